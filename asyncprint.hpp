@@ -0,0 +1,713 @@
+#ifndef ASYNC_PRINT_HPP
+#define ASYNC_PRINT_HPP
+
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "print.hpp"
+#include "vector.hpp"
+
+
+const size_t DEFAULT_LOG_RING_BYTES = 1ul << 18;
+const size_t LOG_STAGING_BYTES      = 1ul << 16;
+const size_t THREAD_PRINTER_SLOTS   = 4;        // printers a thread keeps its rings in at once
+
+
+// what a producer does when its ring has no room for the record
+enum class BackpressurePolicy
+{
+    BLOCK,                                      // waits for the writer thread
+    DROP,                                       // loses the new record
+    OVERWRITE                                   // loses the oldest records
+};
+
+
+// Asynchronous print(): the calling thread copies the format string and the argument values
+// into its own single-producer ring and returns, a writer thread formats the records and
+// hands every batch to the file descriptor with one writev. Strings are copied by value, so
+// the caller may reuse them at once. Messages of one thread keep their order, messages of
+// different threads are only ordered by the batches they land in
+class AsyncPrinter
+{
+    using DecodeFunction = void (*)(PrintBuffer &buffer, const char *record);
+
+    struct RecordHeader
+    {
+        uint32_t bytes = 0;                     // header included, a multiple of RECORD_ALIGNMENT
+        uint32_t reserved = 0;
+        DecodeFunction decode = nullptr;        // nullptr for the filler before the ring wraps
+    };
+
+    // byte ring written by one thread, head_ is moved by the writer thread and, with
+    // OVERWRITE, also by the producer through a CAS; the bytes live in words, so that both
+    // sides can copy them with relaxed atomics while an overwrite is under way
+    struct alignas(64) Ring
+    {
+        Ring(size_t capacity, bool overwrite)
+          : data(reinterpret_cast<char *> (new uint64_t[capacity / sizeof(uint64_t)]())),
+            encoding(overwrite ? reinterpret_cast<char *> (new uint64_t[(capacity >> 1) / sizeof(uint64_t)]()) : nullptr),
+            mask(capacity - 1)
+        {}
+
+        ~Ring()
+        {
+            delete [] reinterpret_cast<uint64_t *> (data);
+            delete [] reinterpret_cast<uint64_t *> (encoding);
+            data     = const_cast<char *> (DESTR_PTR);
+            encoding = const_cast<char *> (DESTR_PTR);
+        }
+
+        char *data = nullptr;
+        char *encoding = nullptr;               // OVERWRITE only: a record is built here, then stored word by word
+        size_t mask = 0;
+
+        alignas(64) std::atomic<uint64_t> head = 0;
+        alignas(64) std::atomic<uint64_t> tail = 0;
+        std::atomic<bool> abandoned = false;    // its thread has exited, the writer frees it once drained
+
+        char staging[LOG_STAGING_BYTES];        // formatted text of the writer's current batch
+        size_t staged = 0;
+    };
+
+    // the calling thread's ring in one printer
+    struct ThreadRing
+    {
+        uint64_t printer_id = 0;
+        uint64_t last_use = 0;
+        std::shared_ptr<Ring> ring;
+
+        ~ThreadRing()
+        {
+            abandon();
+        }
+
+        void abandon()
+        {
+            if (ring != nullptr)
+            {
+                ring->abandoned.store(true, std::memory_order_release);
+            }
+
+            printer_id = 0;
+            ring.reset();
+        }
+    };
+
+    // the rings of the printers the calling thread used last, the least recent one gives way
+    struct ThreadRings
+    {
+        ThreadRing slots[THREAD_PRINTER_SLOTS];
+        uint64_t uses = 0;
+    };
+
+public:
+//---------------------------------------------------------------------------------
+    AsyncPrinter(int fd = STDOUT_FILENO, BackpressurePolicy policy = BackpressurePolicy::BLOCK,
+                 size_t ring_bytes = DEFAULT_LOG_RING_BYTES)
+      : fd_(fd),
+        policy_(policy),
+        ring_bytes_(std::bit_ceil(ring_bytes < MIN_RING_BYTES ? MIN_RING_BYTES : ring_bytes)),
+        id_(next_printer_id_().fetch_add(1, std::memory_order_relaxed))
+    {
+        scratch_ = new char[ring_bytes_];
+        writer_  = std::thread([this] { write_loop_(); });
+    }
+
+    AsyncPrinter(const AsyncPrinter &other) = delete;
+    AsyncPrinter &operator =(const AsyncPrinter &other) = delete;
+
+    // everything printed before is written out
+    ~AsyncPrinter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        writer_.join();
+
+        delete [] scratch_;
+        scratch_ = const_cast<char *> (DESTR_PTR);
+    }
+//---------------------------------------------------------------------------------
+    // false when the record was dropped
+    template<typename... ArgsT>
+    bool print(FormatString<ArgsT...> format, const ArgsT &...args)
+    {
+        using Format = BasicFormatString<std::type_identity_t<ArgsT>...>;
+
+        // the writer formats a record within one staging area, a larger one would come out cut
+        size_t bytes = round_up_(sizeof(RecordHeader) + sizeof(Format) + (encoded_size_(args) + ... + 0));
+        if ((bytes > (ring_bytes_ >> 1)) || (bytes > LOG_STAGING_BYTES))
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+
+            return false;
+        }
+
+        Ring *thread_ring = thread_ring_();
+        if (thread_ring == nullptr)
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+
+            return false;
+        }
+
+        Ring &ring = *thread_ring;
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        if (!reserve_(ring, tail, bytes))
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+
+            return false;
+        }
+
+        char *record = ring.data + (tail & ring.mask);
+        char *target = (ring.encoding != nullptr) ? ring.encoding : record;
+
+        RecordHeader header;
+        header.bytes  = static_cast<uint32_t> (bytes);
+        header.decode = &decode_record_<ArgsT...>;
+        std::memcpy(target, &header, sizeof(header));
+
+        char *cursor = target + sizeof(RecordHeader);
+        std::memcpy(cursor, &format, sizeof(Format));
+        cursor += sizeof(Format);
+
+        ((cursor = encode_(cursor, args)), ...);
+
+        if (target != record)
+        {
+            store_words_(record, target, bytes);
+        }
+
+        ring.tail.store(tail + bytes, std::memory_order_release);
+
+        return true;
+    }
+
+    // returns once the records every thread had published when it was called are written
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        uint64_t ticket = ++flush_requested_;
+        wake_.notify_all();
+        flushed_.wait(lock, [this, ticket] { return flush_completed_ >= ticket; });
+    }
+//---------------------------------------------------------------------------------
+    size_t dropped() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    BackpressurePolicy policy() const
+    {
+        return policy_;
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    static std::atomic<uint64_t> &next_printer_id_()
+    {
+        static std::atomic<uint64_t> id = 1;
+
+        return id;
+    }
+
+    static size_t round_up_(size_t bytes)
+    {
+        return (bytes + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+    }
+
+    // word copies for the ring bytes the writer may read while an OVERWRITE producer reuses
+    // them; torn copies are harmless, the head CAS tells the writer to throw them away
+    static void store_words_(char *destination, const char *source, size_t bytes)
+    {
+        uint64_t *words = reinterpret_cast<uint64_t *> (destination);
+        for (size_t index = 0; index < bytes / sizeof(uint64_t); ++index)
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, source + index * sizeof(uint64_t), sizeof(word));
+            std::atomic_ref<uint64_t>(words[index]).store(word, std::memory_order_relaxed);
+        }
+    }
+
+    static void load_words_(void *destination, const char *source, size_t bytes)
+    {
+        uint64_t *words = reinterpret_cast<uint64_t *> (const_cast<char *> (source));
+        for (size_t index = 0; index < bytes / sizeof(uint64_t); ++index)
+        {
+            uint64_t word = std::atomic_ref<uint64_t>(words[index]).load(std::memory_order_relaxed);
+            std::memcpy(static_cast<char *> (destination) + index * sizeof(uint64_t), &word, sizeof(word));
+        }
+    }
+
+    template<typename Type>
+    static constexpr bool is_string_()
+    {
+        return print_category<Type>() == PrintCategory::STRING;
+    }
+
+    template<typename Type>
+    static size_t encoded_size_(const Type &value)
+    {
+        if constexpr (is_string_<Type>())
+        {
+            return sizeof(uint32_t) + string_of_(value).size();
+        }
+        else
+        {
+            return sizeof(std::decay_t<Type>);
+        }
+    }
+
+    template<typename Type>
+    static std::string_view string_of_(const Type &value)
+    {
+        if constexpr (std::is_pointer_v<Type>)
+        {
+            return (value != nullptr) ? std::string_view(value) : std::string_view("(null)");
+        }
+        else
+        {
+            return std::string_view(value);
+        }
+    }
+
+    // strings as their length and bytes, everything else as its value
+    template<typename Type>
+    static char *encode_(char *cursor, const Type &value)
+    {
+        if constexpr (is_string_<Type>())
+        {
+            std::string_view text = string_of_(value);
+            uint32_t length = static_cast<uint32_t> (text.size());
+
+            std::memcpy(cursor, &length, sizeof(length));
+            std::memcpy(cursor + sizeof(length), text.data(), length);
+
+            return cursor + sizeof(length) + length;
+        }
+        else
+        {
+            std::decay_t<Type> decayed = value;
+            std::memcpy(cursor, &decayed, sizeof(decayed));
+
+            return cursor + sizeof(decayed);
+        }
+    }
+
+    template<typename Type>
+    static auto decode_(const char *&cursor)
+    {
+        if constexpr (is_string_<Type>())
+        {
+            uint32_t length = 0;
+            std::memcpy(&length, cursor, sizeof(length));
+
+            std::string_view text(cursor + sizeof(length), length);
+            cursor += sizeof(length) + length;
+
+            return text;
+        }
+        else
+        {
+            std::decay_t<Type> value;
+            std::memcpy(&value, cursor, sizeof(value));
+            cursor += sizeof(value);
+
+            return value;
+        }
+    }
+
+    template<typename... ArgsT>
+    static void decode_record_(PrintBuffer &buffer, const char *record)
+    {
+        using Format = BasicFormatString<std::type_identity_t<ArgsT>...>;
+
+        alignas(Format) char format_bytes[sizeof(Format)];
+        std::memcpy(format_bytes, record + sizeof(RecordHeader), sizeof(Format));
+        const Format &format = *reinterpret_cast<const Format *> (format_bytes);
+
+        const char *cursor = record + sizeof(RecordHeader) + sizeof(Format);
+        decode_arguments_<ArgsT...>(buffer, format, cursor, std::index_sequence_for<ArgsT...>());
+    }
+
+    template<typename... ArgsT, size_t... Indices>
+    static void decode_arguments_(PrintBuffer &buffer, const BasicFormatString<std::type_identity_t<ArgsT>...> &format,
+                                  const char *cursor, std::index_sequence<Indices...>)
+    {
+        const auto &first = format.piece(0);
+        print_detail::append_piece(buffer, first.begin, first.length, first.escaped);
+
+        ([&]
+        {
+            auto value = decode_<ArgsT>(cursor);
+            print_detail::append_value(buffer, value, format.spec(Indices));
+
+            const auto &next = format.piece(Indices + 1);
+            print_detail::append_piece(buffer, next.begin, next.length, next.escaped);
+        }(), ...);
+    }
+
+    // nullptr if the printer could not take a new ring
+    Ring *thread_ring_()
+    {
+        thread_local ThreadRings thread_rings;
+        ++thread_rings.uses;
+
+        ThreadRing *victim = &thread_rings.slots[0];
+        for (ThreadRing &slot : thread_rings.slots)
+        {
+            if (slot.printer_id == id_)
+            {
+                slot.last_use = thread_rings.uses;
+
+                return slot.ring.get();
+            }
+
+            if (slot.last_use < victim->last_use)
+            {
+                victim = &slot;
+            }
+        }
+
+        std::shared_ptr<Ring> ring = std::make_shared<Ring>(ring_bytes_, policy_ == BackpressurePolicy::OVERWRITE);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            size_t rings_quantity = rings_.size();
+            rings_.push_back(ring);
+            if (rings_.size() != rings_quantity + 1)
+            {
+                std::cerr << "ERROR(AsyncPrinter " << this << "): cannot register a ring for another thread" << std::endl;
+
+                return nullptr;
+            }
+
+            ++rings_version_;
+        }
+
+        victim->abandon();
+        victim->printer_id = id_;
+        victim->last_use   = thread_rings.uses;
+        victim->ring       = std::move(ring);
+
+        return victim->ring.get();
+    }
+
+    // makes room for bytes contiguous bytes at tail, putting a filler before the wrap if needed
+    bool reserve_(Ring &ring, uint64_t &tail, size_t bytes)
+    {
+        size_t to_end = ring_bytes_ - (tail & ring.mask);
+        size_t needed = bytes + ((to_end < bytes) ? to_end : 0);
+
+        while (true)
+        {
+            uint64_t head = ring.head.load(std::memory_order_acquire);
+            if (tail + needed - head <= ring_bytes_)
+            {
+                break;
+            }
+
+            switch (policy_)
+            {
+                case BackpressurePolicy::DROP:
+                    return false;
+
+                case BackpressurePolicy::BLOCK:
+                    std::this_thread::yield();
+                    break;
+
+                case BackpressurePolicy::OVERWRITE:
+                {
+                    RecordHeader oldest;
+                    std::memcpy(&oldest, ring.data + (head & ring.mask), sizeof(oldest));
+                    if (ring.head.compare_exchange_strong(head, head + oldest.bytes, std::memory_order_acq_rel) &&
+                        (oldest.decode != nullptr))
+                    {
+                        dropped_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    break;
+                }
+            }
+        }
+
+        if (to_end < bytes)
+        {
+            RecordHeader filler;
+            filler.bytes = static_cast<uint32_t> (to_end);
+            store_words_(ring.data + (tail & ring.mask), reinterpret_cast<const char *> (&filler), sizeof(filler));
+
+            tail += to_end;
+        }
+
+        return true;
+    }
+
+    // formats what the ring holds into its staging area, false when the staging area is full;
+    // a record is copied out and only used if the head could be moved past it, so that an
+    // OVERWRITE producer reclaiming it at the same time makes the copy void
+    bool drain_ring_(Ring &ring, bool &drained)
+    {
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        uint64_t tail = ring.tail.load(std::memory_order_acquire);
+        while (head < tail)                                                 // an overwrite may move head past the snapshot
+        {
+            size_t position = head & ring.mask;
+
+            RecordHeader header;
+            load_words_(&header, ring.data + position, sizeof(header));
+            if ((header.bytes < sizeof(RecordHeader)) || (header.bytes > ring_bytes_ - position))
+            {
+                head = ring.head.load(std::memory_order_acquire);           // torn by an overwrite, start over
+                continue;
+            }
+
+            load_words_(scratch_, ring.data + position, header.bytes);
+            if (!ring.head.compare_exchange_strong(head, head + header.bytes, std::memory_order_acq_rel))
+            {
+                continue;                                                   // head holds the new value now
+            }
+            head += header.bytes;
+            drained = true;
+
+            if (header.decode == nullptr)
+            {
+                continue;
+            }
+
+            PrintBuffer buffer(ring.staging + ring.staged, LOG_STAGING_BYTES - ring.staged);
+            header.decode(buffer, scratch_);
+            if (buffer.truncated() && (ring.staged > 0))
+            {
+                write_batch_();
+
+                PrintBuffer whole(ring.staging, LOG_STAGING_BYTES);
+                header.decode(whole, scratch_);
+                if (!whole.truncated())
+                {
+                    ring.staged = whole.size();
+
+                    continue;
+                }
+            }
+
+            if (buffer.truncated())                                        // longer than a staging area, not written cut
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+
+                continue;
+            }
+
+            ring.staged += buffer.size();
+            if (ring.staged == LOG_STAGING_BYTES)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // one writev over the staging areas of all rings
+    void write_batch_()
+    {
+        size_t rings_quantity = writer_rings_.size();
+
+        size_t position = 0;
+        while (position < rings_quantity)
+        {
+            iovec vectors[MAX_IOVECS];
+            size_t vectors_quantity = 0;
+            for (; (position < rings_quantity) && (vectors_quantity < MAX_IOVECS); ++position)
+            {
+                Ring &ring = *writer_rings_[position];
+                if (ring.staged > 0)
+                {
+                    vectors[vectors_quantity++] = iovec{ring.staging, ring.staged};
+                }
+            }
+
+            write_vectors_(vectors, vectors_quantity);
+        }
+
+        for (size_t index = 0; index < rings_quantity; ++index)
+        {
+            writer_rings_[index]->staged = 0;
+        }
+    }
+
+    void write_vectors_(iovec *vectors, size_t quantity)
+    {
+        while (quantity > 0)
+        {
+            ssize_t written = writev(fd_, vectors, static_cast<int> (quantity));
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                std::cerr << "ERROR(AsyncPrinter " << this << "): writev failed: " << std::strerror(errno) << std::endl;
+
+                return;
+            }
+
+            size_t left = static_cast<size_t> (written);
+            while ((quantity > 0) && (left >= vectors->iov_len))
+            {
+                left -= vectors->iov_len;
+                ++vectors;
+                --quantity;
+            }
+            if (quantity > 0)
+            {
+                vectors->iov_base = static_cast<char *> (vectors->iov_base) + left;
+                vectors->iov_len -= left;
+            }
+        }
+    }
+
+    // drains every ring until all are empty, frees the ones whose thread has exited;
+    // false if there was nothing to write
+    bool drain_all_()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (writer_rings_version_ != rings_version_)
+            {
+                writer_rings_ = rings_;
+                writer_rings_version_ = rings_version_;
+            }
+        }
+
+        bool drained = false;
+        bool more = true;
+        while (more)
+        {
+            more = false;
+            for (size_t index = 0; index < writer_rings_.size(); ++index)
+            {
+                more |= !drain_ring_(*writer_rings_[index], drained);
+            }
+
+            write_batch_();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t index = 0; index < rings_.size(); )
+        {
+            Ring &ring = *rings_[index];
+            if (ring.abandoned.load(std::memory_order_acquire) &&
+                (ring.head.load(std::memory_order_acquire) == ring.tail.load(std::memory_order_acquire)))
+            {
+                std::swap(rings_[index], rings_.back());
+                rings_.pop_back();
+                ++rings_version_;
+            }
+            else
+            {
+                ++index;
+            }
+        }
+
+        return drained;
+    }
+
+    // sleeps only after a pass that found nothing, producers never have to wake it
+    void write_loop_()
+    {
+        bool idle = true;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            if (idle)
+            {
+                wake_.wait_for(lock, IDLE_PERIOD, [this] { return stopping_ || (flush_requested_ != flush_completed_); });
+            }
+
+            bool stopping = stopping_;
+            uint64_t ticket = flush_requested_;
+
+            lock.unlock();
+            idle = !drain_all_();
+            lock.lock();
+
+            flush_completed_ = ticket;
+            flushed_.notify_all();
+
+            if (stopping)
+            {
+                return;
+            }
+        }
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    static constexpr size_t RECORD_ALIGNMENT = 16;
+    static constexpr size_t MIN_RING_BYTES   = 1ul << 12;
+    static constexpr size_t MAX_IOVECS       = 64;
+    static constexpr std::chrono::milliseconds IDLE_PERIOD = std::chrono::milliseconds(1);
+
+    int fd_ = STDOUT_FILENO;
+    BackpressurePolicy policy_ = BackpressurePolicy::BLOCK;
+    size_t ring_bytes_ = 0;
+    uint64_t id_ = 0;
+
+    std::atomic<size_t> dropped_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    Vector<std::shared_ptr<Ring>> rings_;
+    uint64_t rings_version_ = 0;
+    uint64_t flush_requested_ = 0;
+    uint64_t flush_completed_ = 0;
+    bool stopping_ = false;
+
+    // owned by the writer thread
+    Vector<std::shared_ptr<Ring>> writer_rings_;
+    uint64_t writer_rings_version_ = 0;
+    char *scratch_ = nullptr;
+
+    std::thread writer_;
+};
+
+
+// process-wide printer on standard output, blocking when a thread's ring is full
+inline AsyncPrinter &async_printer()
+{
+    static AsyncPrinter printer;
+
+    return printer;
+}
+
+template<typename... ArgsT>
+bool async_print(FormatString<ArgsT...> format, const ArgsT &...args)
+{
+    return async_printer().print<ArgsT...>(format, args...);
+}
+
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef ATOMIC_BIT_VECTOR_HPP
+#define ATOMIC_BIT_VECTOR_HPP
+
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include "bitvector.hpp"
+#include "bitwords.hpp"
+#include "specialvalues.hpp"
+
+
+// Fixed-size bitset that several threads may write at once: every bit lives in an atomic
+// 64-bit word, indexed exactly like Vector<bool>::get_word (bit i at position 63 - i % 64
+// of word i / 64), so whole words move between the two without reshuffling
+class AtomicBitVector
+{
+public:
+//---------------------------------------------------------------------------------
+    AtomicBitVector(size_t size = 0)
+      : size_(size),
+        words_quantity_(bits_to_words_quantity(size)),
+        words_(new std::atomic<uint64_t>[words_quantity_ > 0 ? words_quantity_ : 1])
+    {
+        for (size_t word = 0; word < words_quantity_; ++word)
+        {
+            words_[word].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    AtomicBitVector(const Vector<bool> &other)
+      : AtomicBitVector(other.size())
+    {
+        for (size_t word = 0; word < words_quantity_; ++word)
+        {
+            words_[word].store(other.get_word(word), std::memory_order_relaxed);
+        }
+    }
+
+    AtomicBitVector(const AtomicBitVector &other) = delete;
+    AtomicBitVector &operator =(const AtomicBitVector &other) = delete;
+
+    ~AtomicBitVector()
+    {
+        delete [] words_;
+
+        words_ = const_cast<std::atomic<uint64_t> *> (reinterpret_cast<const std::atomic<uint64_t> *> (DESTR_PTR));
+        size_  = POISONED_UINT64_T;
+    }
+//--------------------------------Size and capacity--------------------------------
+    size_t size() const
+    {
+        return size_;
+    }
+
+    size_t words_quantity() const
+    {
+        return words_quantity_;
+    }
+//-------------------------------Element access------------------------------------
+    bool test(size_t index, std::memory_order order = std::memory_order_relaxed) const
+    {
+        assert(index < size_);
+
+        return (words_[index >> BITS_TO_WORDS_OFFSET].load(order) & bit_in_word_mask(index & WORD_BITS_MASK)) != 0;
+    }
+
+    bool operator [](size_t index) const
+    {
+        return test(index);
+    }
+
+    uint64_t load_word(size_t word_index, std::memory_order order = std::memory_order_relaxed) const
+    {
+        assert(word_index < words_quantity_);
+
+        return words_[word_index].load(order);
+    }
+//----------------------------------Modifiers--------------------------------------
+    // returns the previous value of the bit, so exactly one of the racing threads sees false
+    bool test_and_set(size_t index, std::memory_order order = std::memory_order_acq_rel)
+    {
+        assert(index < size_);
+
+        uint64_t mask = bit_in_word_mask(index & WORD_BITS_MASK);
+        std::atomic<uint64_t> &word = words_[index >> BITS_TO_WORDS_OFFSET];
+
+        if ((word.load(load_order_(order)) & mask) != 0)                             // already set: no need to own the cache line
+        {
+            return true;
+        }
+
+        return (word.fetch_or(mask, order) & mask) != 0;
+    }
+
+    bool test_and_reset(size_t index, std::memory_order order = std::memory_order_acq_rel)
+    {
+        assert(index < size_);
+
+        uint64_t mask = bit_in_word_mask(index & WORD_BITS_MASK);
+
+        return (words_[index >> BITS_TO_WORDS_OFFSET].fetch_and(~mask, order) & mask) != 0;
+    }
+
+    void set(size_t index, std::memory_order order = std::memory_order_relaxed)
+    {
+        test_and_set(index, order);
+    }
+
+    void reset(size_t index, std::memory_order order = std::memory_order_relaxed)
+    {
+        test_and_reset(index, order);
+    }
+
+    uint64_t fetch_or_word(size_t word_index, uint64_t mask, std::memory_order order = std::memory_order_acq_rel)
+    {
+        assert(word_index < words_quantity_);
+
+        return words_[word_index].fetch_or(mask & tail_mask_(word_index), order);
+    }
+
+    uint64_t fetch_and_word(size_t word_index, uint64_t mask, std::memory_order order = std::memory_order_acq_rel)
+    {
+        assert(word_index < words_quantity_);
+
+        return words_[word_index].fetch_and(mask, order);
+    }
+
+    // ORs a thread-local bitmap in without locks, one RMW per word that adds something new;
+    // returns how many bits this call turned on
+    size_t merge(const Vector<bool> &local, std::memory_order order = std::memory_order_acq_rel)
+    {
+        assert(local.size() <= size_);
+
+        size_t newly_set = 0;
+        size_t local_words = local.words_quantity();
+        for (size_t word = 0; word < local_words; ++word)
+        {
+            uint64_t local_word = local.get_word(word);
+            if ((local_word & ~words_[word].load(std::memory_order_relaxed)) == 0)
+            {
+                continue;
+            }
+
+            uint64_t previous = words_[word].fetch_or(local_word, order);
+            newly_set += std::popcount(local_word & ~previous);
+        }
+
+        return newly_set;
+    }
+
+    // not atomic as a whole: only meaningful while no other thread is writing
+    void clear(std::memory_order order = std::memory_order_relaxed)
+    {
+        for (size_t word = 0; word < words_quantity_; ++word)
+        {
+            words_[word].store(0, order);
+        }
+    }
+//----------------------------------Snapshots--------------------------------------
+    size_t count(std::memory_order order = std::memory_order_relaxed) const
+    {
+        size_t result = 0;
+        for (size_t word = 0; word < words_quantity_; ++word)
+        {
+            result += std::popcount(words_[word].load(order));
+        }
+
+        return result;
+    }
+
+    Vector<bool> to_vector(std::memory_order order = std::memory_order_acquire) const
+    {
+        if (size_ == 0)
+        {
+            return Vector<bool>();
+        }
+
+        Vector<bool> result(size_, false);
+        for (size_t word = 0; word < words_quantity_; ++word)
+        {
+            result.set_word(word, words_[word].load(order));
+        }
+
+        return result;
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    // the load half of a read-modify-write order, so a shortcut taken on a plain load still
+    // synchronises like the fetch_or it replaces would have
+    static std::memory_order load_order_(std::memory_order order)
+    {
+        switch (order)
+        {
+            case std::memory_order_relaxed:
+            case std::memory_order_release:
+                return std::memory_order_relaxed;
+
+            case std::memory_order_seq_cst:
+                return std::memory_order_seq_cst;
+
+            default:
+                return std::memory_order_acquire;
+        }
+    }
+
+    uint64_t tail_mask_(size_t word_index) const
+    {
+        return leading_bits_mask(size_ - (word_index << BITS_TO_WORDS_OFFSET));
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    size_t size_           = 0;
+    size_t words_quantity_ = 0;
+
+    std::atomic<uint64_t> *words_ = nullptr;
+};
+
+
+#endif
@@ -6,6 +6,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <iostream>
+#include <new>
 #include "specialvalues.hpp"
 
 
@@ -14,8 +15,7 @@ class BigArray
 protected:
 //---------------------------------------------------------------------------------
     BigArray(uint64_t capacity = DEFAULT_CAPACITY)
-      : raw_data_(new char[capacity]),
-        end_(raw_data_ + capacity)
+      : raw_data_(new (std::nothrow) char[capacity])
     {
         while (raw_data_ == nullptr)
         {
@@ -26,8 +26,10 @@ protected:
             }
 
             capacity >>= 1;
-            raw_data_ = new char[capacity];
+            raw_data_ = new (std::nothrow) char[capacity];
         }
+
+        end_ = raw_data_ + capacity;
     }
 
     BigArray(const BigArray &other) = delete;
@@ -0,0 +1,192 @@
+#ifndef BIT_COUNT_HPP
+#define BIT_COUNT_HPP
+
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#if defined(__AVX2__) || defined(__AVX512VPOPCNTDQ__)
+#include <immintrin.h>
+#endif
+
+
+const size_t PARALLEL_POPCOUNT_THRESHOLD = (1ull << 26);        // in bits, smaller ranges are not worth a thread
+
+
+#if defined(__AVX2__) && !defined(__AVX512VPOPCNTDQ__)
+inline __m256i popcount_avx2_lanes(__m256i vector)
+{
+    const __m256i lookup   = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                              0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+
+    __m256i low_nibbles  = _mm256_and_si256(vector, low_mask);
+    __m256i high_nibbles = _mm256_and_si256(_mm256_srli_epi32(vector, 4), low_mask);
+    __m256i bytes_counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low_nibbles),
+                                           _mm256_shuffle_epi8(lookup, high_nibbles));
+
+    return _mm256_sad_epu8(bytes_counts, _mm256_setzero_si256());
+}
+
+inline void carry_save_add_avx2(__m256i *high, __m256i *low, __m256i first, __m256i second, __m256i third)
+{
+    __m256i first_xor_second = _mm256_xor_si256(first, second);
+
+    *high = _mm256_or_si256(_mm256_and_si256(first, second), _mm256_and_si256(first_xor_second, third));
+    *low  = _mm256_xor_si256(first_xor_second, third);
+}
+
+// Harley-Seal: a carry-save adder tree over 16 vectors, one real popcount per 16 vectors
+inline uint64_t popcount_avx2(const uint8_t *bytes, size_t vectors_quantity)
+{
+    const __m256i *vectors = reinterpret_cast<const __m256i *> (bytes);
+
+    __m256i total    = _mm256_setzero_si256();
+    __m256i ones     = _mm256_setzero_si256();
+    __m256i twos     = _mm256_setzero_si256();
+    __m256i fours    = _mm256_setzero_si256();
+    __m256i eights   = _mm256_setzero_si256();
+    __m256i sixteens = _mm256_setzero_si256();
+    __m256i twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+    size_t index = 0;
+    for (; index + 16 <= vectors_quantity; index += 16)
+    {
+        carry_save_add_avx2(&twos_a,   &ones,   ones,   _mm256_loadu_si256(vectors + index),      _mm256_loadu_si256(vectors + index + 1));
+        carry_save_add_avx2(&twos_b,   &ones,   ones,   _mm256_loadu_si256(vectors + index + 2),  _mm256_loadu_si256(vectors + index + 3));
+        carry_save_add_avx2(&fours_a,  &twos,   twos,   twos_a, twos_b);
+        carry_save_add_avx2(&twos_a,   &ones,   ones,   _mm256_loadu_si256(vectors + index + 4),  _mm256_loadu_si256(vectors + index + 5));
+        carry_save_add_avx2(&twos_b,   &ones,   ones,   _mm256_loadu_si256(vectors + index + 6),  _mm256_loadu_si256(vectors + index + 7));
+        carry_save_add_avx2(&fours_b,  &twos,   twos,   twos_a, twos_b);
+        carry_save_add_avx2(&eights_a, &fours,  fours,  fours_a, fours_b);
+        carry_save_add_avx2(&twos_a,   &ones,   ones,   _mm256_loadu_si256(vectors + index + 8),  _mm256_loadu_si256(vectors + index + 9));
+        carry_save_add_avx2(&twos_b,   &ones,   ones,   _mm256_loadu_si256(vectors + index + 10), _mm256_loadu_si256(vectors + index + 11));
+        carry_save_add_avx2(&fours_a,  &twos,   twos,   twos_a, twos_b);
+        carry_save_add_avx2(&twos_a,   &ones,   ones,   _mm256_loadu_si256(vectors + index + 12), _mm256_loadu_si256(vectors + index + 13));
+        carry_save_add_avx2(&twos_b,   &ones,   ones,   _mm256_loadu_si256(vectors + index + 14), _mm256_loadu_si256(vectors + index + 15));
+        carry_save_add_avx2(&fours_b,  &twos,   twos,   twos_a, twos_b);
+        carry_save_add_avx2(&eights_b, &fours,  fours,  fours_a, fours_b);
+        carry_save_add_avx2(&sixteens, &eights, eights, eights_a, eights_b);
+
+        total = _mm256_add_epi64(total, popcount_avx2_lanes(sixteens));
+    }
+
+    total = _mm256_slli_epi64(total, 4);
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_avx2_lanes(eights), 3));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_avx2_lanes(fours),  2));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_avx2_lanes(twos),   1));
+    total = _mm256_add_epi64(total, popcount_avx2_lanes(ones));
+
+    for (; index < vectors_quantity; ++index)
+    {
+        total = _mm256_add_epi64(total, popcount_avx2_lanes(_mm256_loadu_si256(vectors + index)));
+    }
+
+    return static_cast<uint64_t> (_mm256_extract_epi64(total, 0)) + static_cast<uint64_t> (_mm256_extract_epi64(total, 1)) +
+           static_cast<uint64_t> (_mm256_extract_epi64(total, 2)) + static_cast<uint64_t> (_mm256_extract_epi64(total, 3));
+}
+#endif
+
+// number of set bits in a byte buffer, order of bits inside the bytes does not matter here
+inline uint64_t popcount_bytes(const uint8_t *bytes, size_t bytes_quantity)
+{
+    assert((bytes != nullptr) || (bytes_quantity == 0));
+
+    uint64_t result = 0;
+    size_t index = 0;
+
+#if defined(__AVX512VPOPCNTDQ__)
+    __m512i total = _mm512_setzero_si512();
+    for (; index + 64 <= bytes_quantity; index += 64)
+    {
+        total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_loadu_si512(bytes + index)));
+    }
+    result += static_cast<uint64_t> (_mm512_reduce_add_epi64(total));
+#elif defined(__AVX2__)
+    size_t vectors_quantity = bytes_quantity / 32;
+    result += popcount_avx2(bytes, vectors_quantity);
+    index = vectors_quantity * 32;
+#endif
+
+    for (; index + 8 <= bytes_quantity; index += 8)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes + index, 8);
+
+        result += std::popcount(word);
+    }
+    for (; index < bytes_quantity; ++index)
+    {
+        result += std::popcount(bytes[index]);
+    }
+
+    return result;
+}
+
+// number of set bits in [from, to) of a packed MSB-first bitmap
+inline uint64_t popcount_bit_range(const uint8_t *data, size_t from, size_t to)
+{
+    if (from >= to)
+    {
+        return 0;
+    }
+
+    size_t first_byte = from >> 3;
+    size_t last_byte  = (to - 1) >> 3;
+
+    uint8_t head_mask = static_cast<uint8_t> (0xFF >> (from & 7));
+    uint8_t tail_mask = static_cast<uint8_t> (0xFF << (7 - ((to - 1) & 7)));
+    if (first_byte == last_byte)
+    {
+        return std::popcount(static_cast<uint8_t> (data[first_byte] & head_mask & tail_mask));
+    }
+
+    return std::popcount(static_cast<uint8_t> (data[first_byte] & head_mask)) +
+           popcount_bytes(data + first_byte + 1, last_byte - first_byte - 1) +
+           std::popcount(static_cast<uint8_t> (data[last_byte] & tail_mask));
+}
+
+// same as popcount_bit_range, split into byte-aligned slices counted by threads_quantity threads
+inline uint64_t popcount_bit_range_parallel(const uint8_t *data, size_t from, size_t to, size_t threads_quantity)
+{
+    if ((threads_quantity <= 1) || (from >= to) || (to - from < PARALLEL_POPCOUNT_THRESHOLD))
+    {
+        return popcount_bit_range(data, from, to);
+    }
+
+    size_t slice_bits = ((to - from) / threads_quantity + 7) & ~7ull;
+
+    uint64_t    *partial_counts = new uint64_t[threads_quantity]{};
+    std::thread *workers        = new std::thread[threads_quantity - 1];
+
+    size_t slice_from = from;
+    for (size_t worker = 0; worker < threads_quantity - 1; ++worker)
+    {
+        size_t slice_to = std::min<size_t>(to, (slice_from + slice_bits) & ~7ull);
+        workers[worker] = std::thread([=]()
+                                      {
+                                          partial_counts[worker] = popcount_bit_range(data, slice_from, slice_to);
+                                      });
+        slice_from = slice_to;
+    }
+    partial_counts[threads_quantity - 1] = popcount_bit_range(data, slice_from, to);
+
+    uint64_t result = partial_counts[threads_quantity - 1];
+    for (size_t worker = 0; worker < threads_quantity - 1; ++worker)
+    {
+        workers[worker].join();
+        result += partial_counts[worker];
+    }
+
+    delete [] workers;
+    delete [] partial_counts;
+
+    return result;
+}
+
+
+#endif
@@ -0,0 +1,320 @@
+#ifndef BIT_MATRIX_HPP
+#define BIT_MATRIX_HPP
+
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <utility>
+#include "bitcount.hpp"
+#include "bitvector.hpp"
+#include "bitwords.hpp"
+#include "specialvalues.hpp"
+
+
+// Transposes a 64x64 tile in place: word i holds row i, column j at position 63 - j
+inline void transpose_bit_tile(uint64_t *tile)
+{
+    assert(tile != nullptr);
+
+    uint64_t mask = 0x00000000FFFFFFFFull;
+    for (size_t width = 32; width != 0; width >>= 1, mask ^= mask << width)
+    {
+        for (size_t row = 0; row < BITS_IN_WORD; row = ((row | width) + 1) & ~width)
+        {
+            uint64_t swapped = (tile[row] ^ (tile[row | width] >> width)) & mask;
+
+            tile[row]         ^= swapped;
+            tile[row | width] ^= swapped << width;
+        }
+    }
+}
+
+
+// Dense boolean matrix: every row is a whole number of cache lines inside one buffer,
+// words of a row are laid out like Vector<bool>::get_word
+class BitMatrix
+{
+public:
+//---------------------------------------------------------------------------------
+    BitMatrix(size_t rows_quantity = 0, size_t columns_quantity = 0)
+      : rows_quantity_   (rows_quantity),
+        columns_quantity_(columns_quantity),
+        words_per_row_   (round_to_line_(bits_to_words_quantity(columns_quantity))),
+        words_(new (std::align_val_t(LINE_ALIGNMENT)) uint64_t[words_quantity_() > 0 ? words_quantity_() : 1]{})
+    {}
+
+    BitMatrix(const BitMatrix &other)
+      : rows_quantity_   (other.rows_quantity_),
+        columns_quantity_(other.columns_quantity_),
+        words_per_row_   (other.words_per_row_),
+        words_(new (std::align_val_t(LINE_ALIGNMENT)) uint64_t[words_quantity_() > 0 ? words_quantity_() : 1])
+    {
+        std::memcpy(words_, other.words_, words_quantity_() * sizeof(uint64_t));
+    }
+
+    BitMatrix(BitMatrix &&other)
+    {
+        swap(other);
+    }
+
+    BitMatrix &operator =(const BitMatrix &other)
+    {
+        BitMatrix copy(other);
+        swap(copy);
+
+        return *this;
+    }
+
+    BitMatrix &operator =(BitMatrix &&other)
+    {
+        swap(other);
+
+        return *this;
+    }
+
+    ~BitMatrix()
+    {
+        ::operator delete[](words_, std::align_val_t(LINE_ALIGNMENT));
+
+        words_         = const_cast<uint64_t *> (reinterpret_cast<const uint64_t *> (DESTR_PTR));
+        rows_quantity_ = POISONED_UINT64_T;
+    }
+
+    void swap(BitMatrix &other)
+    {
+        std::swap(rows_quantity_,    other.rows_quantity_);
+        std::swap(columns_quantity_, other.columns_quantity_);
+        std::swap(words_per_row_,    other.words_per_row_);
+        std::swap(words_,            other.words_);
+    }
+//--------------------------------Size and capacity--------------------------------
+    size_t rows_quantity() const
+    {
+        return rows_quantity_;
+    }
+
+    size_t columns_quantity() const
+    {
+        return columns_quantity_;
+    }
+
+    size_t words_per_row() const
+    {
+        return words_per_row_;
+    }
+//-------------------------------Element access------------------------------------
+    bool test(size_t row, size_t column) const
+    {
+        assert(row < rows_quantity_);
+        assert(column < columns_quantity_);
+
+        return (row_words(row)[column >> BITS_TO_WORDS_OFFSET] & bit_in_word_mask(column & WORD_BITS_MASK)) != 0;
+    }
+
+    void set(size_t row, size_t column, bool value = true)
+    {
+        assert(row < rows_quantity_);
+        assert(column < columns_quantity_);
+
+        uint64_t &word = row_words(row)[column >> BITS_TO_WORDS_OFFSET];
+        uint64_t mask  = bit_in_word_mask(column & WORD_BITS_MASK);
+
+        word = value ? (word | mask) : (word & ~mask);
+    }
+
+    void reset(size_t row, size_t column)
+    {
+        set(row, column, false);
+    }
+
+    const uint64_t *row_words(size_t row) const
+    {
+        assert(row < rows_quantity_);
+
+        return words_ + row * words_per_row_;
+    }
+
+    uint64_t *row_words(size_t row)
+    {
+        assert(row < rows_quantity_);
+
+        return words_ + row * words_per_row_;
+    }
+
+    Vector<bool> row(size_t row) const
+    {
+        if (columns_quantity_ == 0)
+        {
+            return Vector<bool>();
+        }
+
+        Vector<bool> result(columns_quantity_, false);
+        size_t words = result.words_quantity();
+        for (size_t word = 0; word < words; ++word)
+        {
+            result.set_word(word, row_words(row)[word]);
+        }
+
+        return result;
+    }
+
+    void set_row(size_t row, const Vector<bool> &values)
+    {
+        assert(values.size() == columns_quantity_);
+
+        size_t words = values.words_quantity();
+        for (size_t word = 0; word < words; ++word)
+        {
+            row_words(row)[word] = values.get_word(word);
+        }
+    }
+//--------------------------------Row operations-----------------------------------
+    void row_or(size_t target, size_t source)
+    {
+        uint64_t       *target_words = row_words(target);
+        const uint64_t *source_words = row_words(source);
+        for (size_t word = 0; word < words_per_row_; ++word)
+        {
+            target_words[word] |= source_words[word];
+        }
+    }
+
+    void row_and(size_t target, size_t source)
+    {
+        uint64_t       *target_words = row_words(target);
+        const uint64_t *source_words = row_words(source);
+        for (size_t word = 0; word < words_per_row_; ++word)
+        {
+            target_words[word] &= source_words[word];
+        }
+    }
+
+    void row_xor(size_t target, size_t source)
+    {
+        uint64_t       *target_words = row_words(target);
+        const uint64_t *source_words = row_words(source);
+        for (size_t word = 0; word < words_per_row_; ++word)
+        {
+            target_words[word] ^= source_words[word];
+        }
+    }
+
+    size_t row_count(size_t row) const
+    {
+        return popcount_bytes(reinterpret_cast<const uint8_t *> (row_words(row)), words_per_row_ * BYTES_IN_WORD);
+    }
+
+    size_t count() const
+    {
+        return popcount_bytes(reinterpret_cast<const uint8_t *> (words_), words_quantity_() * BYTES_IN_WORD);
+    }
+//-------------------------------Matrix operations---------------------------------
+    // Warshall over words, 64 pivots at a time: the pivot rows are first closed among
+    // themselves, then every other row takes them in while they are still in cache
+    void transitive_closure()
+    {
+        if (rows_quantity_ != columns_quantity_)
+        {
+            std::cerr << "ERROR(BitMatrix " << this << "): transitive closure of a non-square matrix" << std::endl;
+
+            return;
+        }
+
+        for (size_t first_pivot = 0; first_pivot < rows_quantity_; first_pivot += BITS_IN_WORD)
+        {
+            size_t pivot_word = first_pivot >> BITS_TO_WORDS_OFFSET;
+            size_t last_pivot = std::min(first_pivot + BITS_IN_WORD, rows_quantity_);
+
+            for (size_t pivot = first_pivot; pivot < last_pivot; ++pivot)
+            {
+                for (size_t row = first_pivot; row < last_pivot; ++row)
+                {
+                    if (test(row, pivot))
+                    {
+                        row_or(row, pivot);
+                    }
+                }
+            }
+
+            for (size_t row = 0; row < rows_quantity_; ++row)
+            {
+                if ((row >= first_pivot) && (row < last_pivot))
+                {
+                    continue;
+                }
+
+                uint64_t pivots = row_words(row)[pivot_word];
+                while (pivots != 0)
+                {
+                    size_t index_in_word = static_cast<size_t> (std::countl_zero(pivots));
+                    row_or(row, first_pivot + index_in_word);
+
+                    pivots ^= bit_in_word_mask(index_in_word);
+                }
+            }
+        }
+    }
+
+    BitMatrix transpose() const
+    {
+        BitMatrix result(columns_quantity_, rows_quantity_);
+
+        uint64_t tile[BITS_IN_WORD] = {};
+        for (size_t first_row = 0; first_row < rows_quantity_; first_row += BITS_IN_WORD)
+        {
+            size_t tile_rows = std::min(BITS_IN_WORD, rows_quantity_ - first_row);
+            for (size_t first_column = 0; first_column < columns_quantity_; first_column += BITS_IN_WORD)
+            {
+                size_t tile_columns = std::min(BITS_IN_WORD, columns_quantity_ - first_column);
+                size_t column_word  = first_column >> BITS_TO_WORDS_OFFSET;
+
+                for (size_t row = 0; row < BITS_IN_WORD; ++row)
+                {
+                    tile[row] = (row < tile_rows) ? row_words(first_row + row)[column_word] : 0;
+                }
+
+                transpose_bit_tile(tile);
+
+                size_t row_word = first_row >> BITS_TO_WORDS_OFFSET;
+                for (size_t column = 0; column < tile_columns; ++column)
+                {
+                    result.row_words(first_column + column)[row_word] = tile[column];
+                }
+            }
+        }
+
+        return result;
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    static size_t round_to_line_(size_t words_quantity)
+    {
+        return (words_quantity + WORDS_IN_LINE - 1) & ~(WORDS_IN_LINE - 1);
+    }
+
+    size_t words_quantity_() const
+    {
+        return rows_quantity_ * words_per_row_;
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    static constexpr size_t LINE_ALIGNMENT = 64;
+    static constexpr size_t WORDS_IN_LINE  = LINE_ALIGNMENT / BYTES_IN_WORD;
+
+    size_t rows_quantity_    = 0;
+    size_t columns_quantity_ = 0;
+    size_t words_per_row_    = 0;
+
+    uint64_t *words_ = nullptr;
+};
+
+
+#endif
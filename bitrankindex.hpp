@@ -0,0 +1,232 @@
+#ifndef BIT_RANK_INDEX_HPP
+#define BIT_RANK_INDEX_HPP
+
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "bitwords.hpp"
+
+
+// Two-level rank directory over a packed MSB-first bitmap: an absolute count per 4096-bit
+// superblock and a 16-bit relative count per 512-bit block (about 4.7% of the bitmap),
+// plus a superblock sample every 8192 ones to narrow select down
+class BitRankIndex
+{
+public:
+//---------------------------------------------------------------------------------
+    BitRankIndex() = default;
+
+    BitRankIndex(const BitRankIndex &other) = delete;
+    BitRankIndex &operator =(const BitRankIndex &other) = delete;
+
+    ~BitRankIndex()
+    {
+        reset();
+    }
+//---------------------------------------------------------------------------------
+    void build(const uint8_t *data, size_t bits_quantity)
+    {
+        reset();
+
+        data_          = data;
+        bits_quantity_ = bits_quantity;
+
+        size_t words_quantity       = bits_to_words_quantity(bits_quantity);
+        size_t blocks_quantity      = (words_quantity + WORDS_IN_BLOCK - 1) / WORDS_IN_BLOCK;
+        size_t superblocks_quantity = (words_quantity + WORDS_IN_SUPERBLOCK - 1) / WORDS_IN_SUPERBLOCK;
+
+        superblock_ranks_ = new uint64_t[superblocks_quantity + 1];
+        block_ranks_      = new uint16_t[blocks_quantity + 1];
+
+        uint64_t ones = 0;
+        for (size_t superblock = 0; superblock < superblocks_quantity; ++superblock)
+        {
+            superblock_ranks_[superblock] = ones;
+
+            uint64_t ones_in_superblock = 0;
+            size_t first_block = superblock * BLOCKS_IN_SUPERBLOCK;
+            for (size_t block = first_block; (block < first_block + BLOCKS_IN_SUPERBLOCK) && (block < blocks_quantity); ++block)
+            {
+                block_ranks_[block] = static_cast<uint16_t> (ones_in_superblock);
+
+                for (size_t word = block * WORDS_IN_BLOCK; (word < (block + 1) * WORDS_IN_BLOCK) && (word < words_quantity); ++word)
+                {
+                    ones_in_superblock += std::popcount(get_word_(word));
+                }
+            }
+
+            ones += ones_in_superblock;
+        }
+        superblock_ranks_[superblocks_quantity] = ones;
+        block_ranks_[blocks_quantity]           = 0;
+
+        superblocks_quantity_ = superblocks_quantity;
+        ones_                 = ones;
+
+        size_t samples_quantity = ones / SELECT_SAMPLE_RATE + 1;
+        select_samples_ = new uint64_t[samples_quantity];
+
+        size_t superblock = 0;
+        for (size_t sample = 0; sample < samples_quantity; ++sample)
+        {
+            uint64_t wanted_rank = sample * SELECT_SAMPLE_RATE;
+            while ((superblock + 1 < superblocks_quantity) && (superblock_ranks_[superblock + 1] <= wanted_rank))
+            {
+                ++superblock;
+            }
+
+            select_samples_[sample] = superblock;
+        }
+        samples_quantity_ = samples_quantity;
+    }
+
+    void reset()
+    {
+        delete [] superblock_ranks_;
+        delete [] block_ranks_;
+        delete [] select_samples_;
+
+        superblock_ranks_ = nullptr;
+        block_ranks_      = nullptr;
+        select_samples_   = nullptr;
+
+        data_                 = nullptr;
+        bits_quantity_        = 0;
+        superblocks_quantity_ = 0;
+        samples_quantity_     = 0;
+        ones_                 = 0;
+    }
+
+    bool is_built() const
+    {
+        return superblock_ranks_ != nullptr;
+    }
+
+    void swap(BitRankIndex &other) noexcept
+    {
+        std::swap(data_,                 other.data_);
+        std::swap(bits_quantity_,        other.bits_quantity_);
+        std::swap(superblock_ranks_,     other.superblock_ranks_);
+        std::swap(block_ranks_,          other.block_ranks_);
+        std::swap(select_samples_,       other.select_samples_);
+        std::swap(superblocks_quantity_, other.superblocks_quantity_);
+        std::swap(samples_quantity_,     other.samples_quantity_);
+        std::swap(ones_,                 other.ones_);
+    }
+//---------------------------------------------------------------------------------
+    size_t ones() const
+    {
+        return ones_;
+    }
+
+    // number of set bits in [0, index)
+    size_t rank1(size_t index) const
+    {
+        assert(is_built());
+        assert(index <= bits_quantity_);
+
+        if (index == bits_quantity_)
+        {
+            return ones_;
+        }
+
+        size_t word  = index >> BITS_TO_WORDS_OFFSET;
+        size_t block = word / WORDS_IN_BLOCK;
+
+        uint64_t rank = superblock_ranks_[word / WORDS_IN_SUPERBLOCK] + block_ranks_[block];
+        for (size_t cur_word = block * WORDS_IN_BLOCK; cur_word < word; ++cur_word)
+        {
+            rank += std::popcount(get_word_(cur_word));
+        }
+
+        return rank + std::popcount(get_word_(word) & leading_bits_mask(index & WORD_BITS_MASK));
+    }
+
+    // position of the set bit with rank k (counting from zero), bits quantity if there is none
+    size_t select1(size_t k) const
+    {
+        assert(is_built());
+
+        if (k >= ones_)
+        {
+            return bits_quantity_;
+        }
+
+        size_t sample = k / SELECT_SAMPLE_RATE;
+        size_t left   = select_samples_[sample];
+        size_t right  = (sample + 1 < samples_quantity_) ? select_samples_[sample + 1] + 1 : superblocks_quantity_;
+        while (right - left > 1)
+        {
+            size_t middle = left + ((right - left) >> 1);
+            if (superblock_ranks_[middle] <= k)
+            {
+                left = middle;
+            }
+            else
+            {
+                right = middle;
+            }
+        }
+
+        size_t remaining   = k - superblock_ranks_[left];
+        size_t first_block = left * BLOCKS_IN_SUPERBLOCK;
+        size_t last_block  = std::min(first_block + BLOCKS_IN_SUPERBLOCK,
+                                      (bits_to_words_quantity(bits_quantity_) + WORDS_IN_BLOCK - 1) / WORDS_IN_BLOCK);
+        size_t block = first_block;
+        while ((block + 1 < last_block) && (block_ranks_[block + 1] <= remaining))
+        {
+            ++block;
+        }
+        remaining -= block_ranks_[block];
+
+        size_t word = block * WORDS_IN_BLOCK;
+        while (true)
+        {
+            uint64_t cur_word = get_word_(word);
+            size_t ones_in_word = static_cast<size_t> (std::popcount(cur_word));
+            if (remaining < ones_in_word)
+            {
+                return (word << BITS_TO_WORDS_OFFSET) + select_in_bit_word(cur_word, remaining);
+            }
+
+            remaining -= ones_in_word;
+            ++word;
+        }
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    uint64_t get_word_(size_t word_index) const
+    {
+        size_t first_bit = word_index << BITS_TO_WORDS_OFFSET;
+        size_t bytes_quantity = bits_to_covering_bytes_quantity(bits_quantity_) - (first_bit >> 3);
+
+        return load_bit_word(data_ + (first_bit >> 3), bytes_quantity) &
+               leading_bits_mask(bits_quantity_ - first_bit);
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    static constexpr size_t WORDS_IN_BLOCK       = 8;
+    static constexpr size_t BLOCKS_IN_SUPERBLOCK = 8;
+    static constexpr size_t WORDS_IN_SUPERBLOCK  = WORDS_IN_BLOCK * BLOCKS_IN_SUPERBLOCK;
+    static constexpr size_t SELECT_SAMPLE_RATE   = 8192;
+
+    const uint8_t *data_  = nullptr;
+    size_t bits_quantity_ = 0;
+
+    uint64_t *superblock_ranks_ = nullptr;
+    uint16_t *block_ranks_      = nullptr;
+    uint64_t *select_samples_   = nullptr;
+
+    size_t superblocks_quantity_ = 0;
+    size_t samples_quantity_     = 0;
+    size_t ones_                 = 0;
+};
+
+
+#endif
@@ -0,0 +1,443 @@
+#ifndef BIT_SPAN_HPP
+#define BIT_SPAN_HPP
+
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "bitcount.hpp"
+#include "bitvector.hpp"
+#include "bitwords.hpp"
+
+
+// Non-owning view over size bits of packed memory starting offset bits into data, with
+// either bit order inside a byte. Words are served in the layout of Vector<bool>::get_word,
+// so the algorithms below are the same word loops Vector<bool> runs over its own buffer
+template<typename ByteType>
+class BasicBitSpan
+{
+public:
+    static constexpr bool IS_MUTABLE = !std::is_const_v<ByteType>;
+//---------------------------------------------------------------------------------
+    BasicBitSpan() = default;
+
+    BasicBitSpan(ByteType *data, size_t size, size_t offset = 0, BitOrder order = BitOrder::MSB_FIRST)
+      : data_(data + (offset >> 3)),
+        offset_(offset & 7),
+        size_(size),
+        order_(order)
+    {
+        assert((data != nullptr) || (size == 0));
+    }
+
+    BasicBitSpan(const Vector<bool> &vector) requires (!IS_MUTABLE)
+      : BasicBitSpan(vector.data(), vector.size())
+    {}
+
+    BasicBitSpan(Vector<bool> &vector) requires IS_MUTABLE
+      : BasicBitSpan(vector.data(), vector.size())
+    {}
+
+    template<typename OtherByteType>
+        requires (!IS_MUTABLE && !std::is_same_v<OtherByteType, ByteType>)
+    BasicBitSpan(const BasicBitSpan<OtherByteType> &other)
+      : BasicBitSpan(other.data(), other.size(), other.offset(), other.order())
+    {}
+//--------------------------------Size and layout----------------------------------
+    size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    ByteType *data() const
+    {
+        return data_;
+    }
+
+    size_t offset() const
+    {
+        return offset_;
+    }
+
+    BitOrder order() const
+    {
+        return order_;
+    }
+
+    BasicBitSpan subspan(size_t from, size_t to) const
+    {
+        assert(from <= to);
+        assert(to <= size_);
+
+        return BasicBitSpan(data_, to - from, offset_ + from, order_);
+    }
+//-------------------------------Element access------------------------------------
+    bool test(size_t index) const
+    {
+        assert(index < size_);
+
+        size_t position = offset_ + index;
+
+        return (data_[position >> 3] & bit_in_byte_mask_(position & 7)) != 0;
+    }
+
+    bool operator [](size_t index) const
+    {
+        return test(index);
+    }
+//----------------------------------Word access------------------------------------
+    size_t words_quantity() const
+    {
+        return bits_to_words_quantity(size_);
+    }
+
+    uint64_t get_word(size_t word_index) const
+    {
+        assert(word_index < words_quantity());
+
+        size_t first_bit  = offset_ + (word_index << BITS_TO_WORDS_OFFSET);
+        size_t first_byte = first_bit >> 3;
+        size_t shift      = first_bit & 7;
+        size_t bytes_left = covering_bytes_() - first_byte;
+
+        uint64_t word = 0;
+        if (order_ == BitOrder::MSB_FIRST)
+        {
+            word = load_bit_word(data_ + first_byte, bytes_left) << shift;
+            if ((shift != 0) && (bytes_left > BYTES_IN_WORD))
+            {
+                word |= static_cast<uint64_t> (data_[first_byte + BYTES_IN_WORD]) >> (8 - shift);
+            }
+        }
+        else
+        {
+            word = load_lsb_word_(data_ + first_byte, bytes_left) >> shift;
+            if ((shift != 0) && (bytes_left > BYTES_IN_WORD))
+            {
+                word |= static_cast<uint64_t> (data_[first_byte + BYTES_IN_WORD]) << (BITS_IN_WORD - shift);
+            }
+
+            word = reverse_bit_word(word);
+        }
+
+        return word & leading_bits_mask(size_ - (word_index << BITS_TO_WORDS_OFFSET));
+    }
+
+    void set_word(size_t word_index, uint64_t word) requires IS_MUTABLE
+    {
+        assert(word_index < words_quantity());
+
+        size_t first_bit  = offset_ + (word_index << BITS_TO_WORDS_OFFSET);
+        size_t first_byte = first_bit >> 3;
+        size_t shift      = first_bit & 7;
+        uint64_t mask     = leading_bits_mask(size_ - (word_index << BITS_TO_WORDS_OFFSET));
+
+        if (order_ == BitOrder::LSB_FIRST)
+        {
+            word = reverse_bit_word(word);
+            mask = reverse_bit_word(mask);
+        }
+
+        for (size_t byte_index = 0; byte_index <= BYTES_IN_WORD; ++byte_index)
+        {
+            uint8_t byte_mask = byte_of_word_(mask, byte_index, shift);
+            if (byte_mask == 0)
+            {
+                continue;
+            }
+
+            uint8_t &byte = data_[first_byte + byte_index];
+            byte = static_cast<uint8_t> ((byte & ~byte_mask) | (byte_of_word_(word, byte_index, shift) & byte_mask));
+        }
+    }
+//--------------------------------Population count---------------------------------
+    size_t count() const
+    {
+        if ((offset_ == 0) && (size_ >= BITS_IN_BYTE))
+        {
+            size_t full_bytes = size_ >> 3;
+            size_t result     = popcount_bytes(reinterpret_cast<const uint8_t *> (data_), full_bytes);
+
+            return result + ((size_ & 7) != 0 ? subspan(full_bytes << 3, size_).count() : 0);
+        }
+
+        size_t result = 0;
+        size_t words  = words_quantity();
+        for (size_t word = 0; word < words; ++word)
+        {
+            result += static_cast<size_t> (std::popcount(get_word(word)));
+        }
+
+        return result;
+    }
+
+    size_t count(size_t from, size_t to) const
+    {
+        return subspan(from, to).count();
+    }
+
+    bool all() const
+    {
+        return find_forward_(0, false) == size_;
+    }
+
+    bool any() const
+    {
+        return find_forward_(0, true) != size_;
+    }
+
+    bool none() const
+    {
+        return !any();
+    }
+//----------------------------------Bit search-------------------------------------
+    // every search returns size() when nothing is found
+    size_t find_first() const
+    {
+        return find_forward_(0, true);
+    }
+
+    size_t find_next(size_t pos) const
+    {
+        return find_forward_(pos + 1, true);
+    }
+
+    size_t find_last() const
+    {
+        return find_backward_(size_, true);
+    }
+
+    size_t find_prev(size_t pos) const
+    {
+        return find_backward_(pos, true);
+    }
+
+    size_t find_first_zero() const
+    {
+        return find_forward_(0, false);
+    }
+
+    size_t find_next_zero(size_t pos) const
+    {
+        return find_forward_(pos + 1, false);
+    }
+
+    template<typename Visitor>
+    void for_each_set_bit(Visitor visitor) const
+    {
+        size_t words = words_quantity();
+        for (size_t word = 0; word < words; ++word)
+        {
+            uint64_t cur_word = get_word(word);
+            while (cur_word != 0)
+            {
+                size_t index_in_word = static_cast<size_t> (std::countl_zero(cur_word));
+                visitor((word << BITS_TO_WORDS_OFFSET) + index_in_word);
+
+                cur_word ^= bit_in_word_mask(index_in_word);
+            }
+        }
+    }
+//----------------------------------Modifiers--------------------------------------
+    void set(size_t index, bool value = true) requires IS_MUTABLE
+    {
+        assert(index < size_);
+
+        size_t position = offset_ + index;
+        uint8_t mask    = bit_in_byte_mask_(position & 7);
+        uint8_t &byte   = data_[position >> 3];
+
+        byte = static_cast<uint8_t> (value ? (byte | mask) : (byte & ~mask));
+    }
+
+    void reset(size_t index) requires IS_MUTABLE
+    {
+        set(index, false);
+    }
+
+    void fill(bool value) requires IS_MUTABLE
+    {
+        size_t words = words_quantity();
+        for (size_t word = 0; word < words; ++word)
+        {
+            set_word(word, value ? ~0ull : 0ull);
+        }
+    }
+
+    template<typename OtherByteType>
+    void assign(const BasicBitSpan<OtherByteType> &other) requires IS_MUTABLE
+    {
+        assert(other.size() == size_);
+
+        size_t words = words_quantity();
+        for (size_t word = 0; word < words; ++word)
+        {
+            set_word(word, other.get_word(word));
+        }
+    }
+
+    void assign(const Vector<bool> &other) requires IS_MUTABLE
+    {
+        assert(other.size() == size_);
+
+        size_t words = words_quantity();
+        for (size_t word = 0; word < words; ++word)
+        {
+            set_word(word, other.get_word(word));
+        }
+    }
+//---------------------------------Conversions-------------------------------------
+    Vector<bool> to_vector() const
+    {
+        if (size_ == 0)
+        {
+            return Vector<bool>();
+        }
+
+        Vector<bool> result(size_, false);
+        size_t words = words_quantity();
+        for (size_t word = 0; word < words; ++word)
+        {
+            result.set_word(word, get_word(word));
+        }
+
+        return result;
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    uint8_t bit_in_byte_mask_(size_t index_in_byte) const
+    {
+        return static_cast<uint8_t> (order_ == BitOrder::MSB_FIRST ? 0x80 >> index_in_byte : 0x01 << index_in_byte);
+    }
+
+    size_t covering_bytes_() const
+    {
+        return bits_to_covering_bytes_quantity(offset_ + size_);
+    }
+
+    static uint64_t load_lsb_word_(const uint8_t *bytes, size_t bytes_quantity)
+    {
+        if (bytes_quantity >= BYTES_IN_WORD)
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes, BYTES_IN_WORD);
+
+            if constexpr (std::endian::native == std::endian::big)
+            {
+                word = __builtin_bswap64(word);
+            }
+
+            return word;
+        }
+
+        uint64_t word = 0;
+        for (size_t byte_index = 0; byte_index < bytes_quantity; ++byte_index)
+        {
+            word |= static_cast<uint64_t> (bytes[byte_index]) << (byte_index << 3);
+        }
+
+        return word;
+    }
+
+    // byte_index-th of the nine bytes a word covers once it is moved shift bits into its
+    // first byte; for LSB_FIRST the word has already been bit-reversed
+    uint8_t byte_of_word_(uint64_t word, size_t byte_index, size_t shift) const
+    {
+        if (order_ == BitOrder::MSB_FIRST)
+        {
+            if (byte_index < BYTES_IN_WORD)
+            {
+                return static_cast<uint8_t> ((word >> shift) >> (WORD_BITS_MASK - 7 - (byte_index << 3)));
+            }
+
+            return (shift != 0) ? static_cast<uint8_t> (word << (8 - shift)) : 0;
+        }
+
+        if (byte_index < BYTES_IN_WORD)
+        {
+            return static_cast<uint8_t> ((word << shift) >> (byte_index << 3));
+        }
+
+        return (shift != 0) ? static_cast<uint8_t> (word >> (BITS_IN_WORD - shift)) : 0;
+    }
+
+    // first bit equal to value in [from, size_)
+    size_t find_forward_(size_t from, bool value) const
+    {
+        if (from >= size_)
+        {
+            return size_;
+        }
+
+        size_t words = words_quantity();
+        size_t word  = from >> BITS_TO_WORDS_OFFSET;
+        uint64_t cur_word = get_search_word_(word, value) & ~leading_bits_mask(from & WORD_BITS_MASK);
+        while (cur_word == 0)
+        {
+            if (++word == words)
+            {
+                return size_;
+            }
+
+            cur_word = get_search_word_(word, value);
+        }
+
+        return (word << BITS_TO_WORDS_OFFSET) + static_cast<size_t> (std::countl_zero(cur_word));
+    }
+
+    // last bit equal to value in [0, to)
+    size_t find_backward_(size_t to, bool value) const
+    {
+        if (to > size_)
+        {
+            to = size_;
+        }
+        if (to == 0)
+        {
+            return size_;
+        }
+
+        size_t word = (to - 1) >> BITS_TO_WORDS_OFFSET;
+        uint64_t cur_word = get_search_word_(word, value) & leading_bits_mask(to - (word << BITS_TO_WORDS_OFFSET));
+        while (cur_word == 0)
+        {
+            if (word-- == 0)
+            {
+                return size_;
+            }
+
+            cur_word = get_search_word_(word, value);
+        }
+
+        return (word << BITS_TO_WORDS_OFFSET) + WORD_BITS_MASK - static_cast<size_t> (std::countr_zero(cur_word));
+    }
+
+    uint64_t get_search_word_(size_t word_index, bool value) const
+    {
+        uint64_t word = get_word(word_index);
+
+        return value ? word : ~word & leading_bits_mask(size_ - (word_index << BITS_TO_WORDS_OFFSET));
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    ByteType *data_   = nullptr;
+    size_t    offset_ = 0;
+    size_t    size_   = 0;
+    BitOrder  order_  = BitOrder::MSB_FIRST;
+};
+
+using BitSpan      = BasicBitSpan<uint8_t>;
+using ConstBitSpan = BasicBitSpan<const uint8_t>;
+
+
+#endif
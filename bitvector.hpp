@@ -3,12 +3,20 @@
 
 
 #include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <initializer_list>
 #include <iterator>
+#include <limits>
 #include <type_traits>
+#include "bitcount.hpp"
+#include "bitrankindex.hpp"
+#include "bitwords.hpp"
+#include "memoryutilities.hpp"
 #include "mymove.hpp"
 #include "vector.hpp"
 
@@ -75,8 +83,8 @@ struct BitsAndBytes
 };
 
 
-template<>
-class Vector<bool>
+template<typename GrowthPolicy>
+class Vector<bool, GrowthPolicy>
 {
     class BitReference;
 
@@ -229,13 +237,15 @@ class Vector<bool>
 //         size_t shift_ = 0;
 //     };
 
+    // a writable reference knows its container, so that a write drops the rank index there
     class BitReference
     {
     public:
 //---------------------------------------------------------------------------------
-        BitReference(uint8_t *byte, size_t shift = MAX_SHIFT)
+        BitReference(uint8_t *byte, size_t shift = MAX_SHIFT, Vector *container = nullptr)
           : byte_(byte),
-            shift_(shift)
+            shift_(shift),
+            container_(container)
         {
             assert(byte != nullptr);
             assert(shift <= MAX_SHIFT);
@@ -243,15 +253,18 @@ class Vector<bool>
 
         BitReference(const BitReference &other)
           : byte_(other.byte_),
-            shift_(other.shift_)
+            shift_(other.shift_),
+            container_(other.container_)
         {}
 
         BitReference(BitReference &&other)
           : byte_(other.byte_),
-            shift_(other.shift_)
+            shift_(other.shift_),
+            container_(other.container_)
         {
-            other.byte_  = const_cast<uint8_t *> (reinterpret_cast<const uint8_t *> (MOVED_REMAINDERS_PTR));
-            other.shift_ = 0;
+            other.byte_      = const_cast<uint8_t *> (reinterpret_cast<const uint8_t *> (MOVED_REMAINDERS_PTR));
+            other.shift_     = 0;
+            other.container_ = nullptr;
         }
 
         BitReference &operator =(bool bit_value)
@@ -279,6 +292,7 @@ class Vector<bool>
         {
              byte_ = const_cast<uint8_t *> (reinterpret_cast<const uint8_t *> (DESTR_PTR));
             shift_ = POISONED_UINT64_T;
+            container_ = nullptr;
         }
 
     public:
@@ -298,12 +312,18 @@ class Vector<bool>
     void set_bit_(bool bit_value)
     {
         *byte_ = bit_value ? (*byte_ | (0x1 << shift_)) : (*byte_ & ~(0x1 << shift_));
+
+        if (container_ != nullptr)
+        {
+            container_->invalidate_rank_index_();
+        }
     }
 
     private:
 //----------------------------------Variables--------------------------------------
         uint8_t *byte_ = reinterpret_cast<uint8_t *> (const_cast<char *> (UNINIT_PTR));
         size_t shift_  = 0;
+        Vector *container_ = nullptr;
     };
 
     template<typename Container, typename ItType>
@@ -395,7 +415,14 @@ class Vector<bool>
 //---------------------------------------------------------------------------------
         reference operator *() const
         {
-            return reference(data_, shift_);
+            if constexpr (is_const)
+            {
+                return reference(data_, shift_);
+            }
+            else
+            {
+                return reference(data_, shift_, container_);
+            }
         }
 
         BitIterator &operator ++()
@@ -446,24 +473,10 @@ class Vector<bool>
 
         BitIterator &operator +=(difference_type value)
         {
-            if (value > 0)
-            {
-                while (value > 0)
-                {
-                    ++(*this);
+            difference_type bit = static_cast<difference_type> (MAX_SHIFT - shift_) + value;
 
-                    --value;
-                }
-            }
-            else
-            {
-                while (value < 0)
-                {
-                    --(*this);
-
-                    ++value;
-                }
-            }
+            data_ += bit >> BITS_TO_BYTES_OFFSET;
+            shift_ = MAX_SHIFT - static_cast<size_t> (bit & static_cast<difference_type> (MAX_SHIFT));
 
             return *this;
         }
@@ -597,6 +610,85 @@ class Vector<bool>
         size_t shift_  = 0;
     };
 
+    class SetBitIterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = size_t;
+        using difference_type   = ptrdiff_t;
+        using reference         = size_t;
+        using pointer           = void;
+//---------------------------------------------------------------------------------
+        SetBitIterator() = default;
+
+        SetBitIterator(const Vector *container, size_t position)
+          : container_(container),
+            position_(position)
+        {
+            assert(container != nullptr);
+        }
+//---------------------------------------------------------------------------------
+        size_t operator *() const
+        {
+            return position_;
+        }
+
+        SetBitIterator &operator ++()
+        {
+            position_ = container_->find_next(position_);
+
+            return *this;
+        }
+
+        SetBitIterator operator ++(int)
+        {
+            SetBitIterator prev = *this;
+            ++(*this);
+
+            return prev;
+        }
+
+        bool operator ==(const SetBitIterator &other) const
+        {
+            return position_ == other.position_;
+        }
+
+        bool operator !=(const SetBitIterator &other) const
+        {
+            return !operator ==(other);
+        }
+
+    private:
+//-------------------------------------Variables-----------------------------------
+        const Vector *container_ = nullptr;
+        size_t position_ = 0;
+    };
+
+    class SetBitRange
+    {
+    public:
+//---------------------------------------------------------------------------------
+        SetBitRange(const Vector *container)
+          : container_(container)
+        {
+            assert(container != nullptr);
+        }
+//---------------------------------------------------------------------------------
+        SetBitIterator begin() const
+        {
+            return SetBitIterator(container_, container_->find_first());
+        }
+
+        SetBitIterator end() const
+        {
+            return SetBitIterator(container_, container_->size());
+        }
+
+    private:
+//-------------------------------------Variables-----------------------------------
+        const Vector *container_ = nullptr;
+    };
+
 public:
 
     using value_type        = bool;
@@ -606,9 +698,9 @@ public:
     using const_reference   = const BitReference;
     using difference_type   = std::ptrdiff_t;
 
-    using Iterator = BitIterator<Vector<bool>, bool>;
+    using Iterator = BitIterator<Vector, bool>;
 
-    using ConstIterator = BitIterator<const Vector<bool>, const bool>;
+    using ConstIterator = BitIterator<const Vector, const bool>;
 //---------------------------------------------------------------------------------
     Vector()
       : capacity_       (0),
@@ -617,6 +709,12 @@ public:
         data_           (reinterpret_cast<uint8_t *> (const_cast<char *> (UNINIT_PTR)))
     {}
 
+    explicit Vector(Allocator &alloc)
+      : Vector()
+    {
+        alloc_ = &alloc;
+    }
+
     Vector(const std::initializer_list<bool> &init_list)
     {
         size_t list_size = init_list.size();
@@ -627,70 +725,68 @@ public:
     }
 
     Vector(const size_t reserved_size, bool value = false)
+      : Vector(reserved_size, value, *default_allocator())
+    {}
+
+    Vector(const size_t reserved_size, bool value, Allocator &alloc)
       : capacity_       (round_to_eight_multiple(reserved_size)),
         booked_capacity_(reserved_size),
         size_           (reserved_size),
-        data_(new uint8_t[bits_to_bytes_quantity(capacity_)]{value})
+        alloc_          (&alloc),
+        data_           (allocate_data_(capacity_))
     {
+        std::memset(data_, 0, bits_to_bytes_quantity(capacity_));
         if (reserved_size != 0)
         {   
             init_elements_(0, reserved_size, value);
         }
     }
 
-    Vector(const Vector<bool> &other)
+    Vector(const Vector &other)
       : capacity_(round_to_eight_multiple(other.capacity_)),
         booked_capacity_(other.capacity_),
         size_(other.size_),
-        data_(new uint8_t[bits_to_bytes_quantity(capacity_)])
+        data_(allocate_data_(capacity_))
     {
-        // BitIterator<false> data_copy_to(this, data_);
-        // BitIterator<true> data_copy_from(this, other.data_);
-        Iterator data_copy_to(this, data_);
-        ConstIterator data_copy_from(this, other.data_);
-        copy_data_(data_copy_to, data_copy_from, booked_capacity_);
+        copy_block(data_, other.data_, bits_to_bytes_quantity(other.capacity_));
     }
 
-    Vector(Vector<bool> &&other)
+    Vector(Vector &&other) noexcept
     {
         *this = std::move(other);
     }
 
-    Vector<bool> &operator =(const Vector<bool> &other)
+    Vector &operator =(const Vector &other)
     {
-        if ((data_ != const_cast<uint8_t *> (reinterpret_cast<const uint8_t *> (UNINIT_PTR))) && data_is_valid_())
-        {
-            delete [] data_;
-        }
+        invalidate_rank_index_();
+
+        free_data_();
 
         capacity_        = other.capacity_;
         booked_capacity_ = other.booked_capacity_;
         size_            = other.size_;
-        data_            = new uint8_t[bits_to_bytes_quantity(capacity_)];
+        data_            = allocate_data_(capacity_);
 
-        // BitIterator<false> data_copy_to( this, data_);
-        // BitIterator<true> data_copy_from(this, other.data_);
-        // copy_data_(data_copy_to, data_copy_from, booked_capacity_);
-        Iterator data_copy_to(this, data_);
-        ConstIterator data_copy_from(this, other.data_);
-        copy_data_(data_copy_to, data_copy_from, booked_capacity_);
+        copy_block(data_, other.data_, bits_to_bytes_quantity(capacity_));
 
         return *this;
     }
 
-    Vector<bool> &operator =(Vector<bool> &&other)
+    Vector &operator =(Vector &&other) noexcept
     {
         std::swap(capacity_, other.capacity_);
         std::swap(booked_capacity_, other.booked_capacity_);
         std::swap(size_, other.size_);
+        std::swap(alloc_, other.alloc_);
         std::swap(data_, other.data_);
+        rank_index_.swap(other.rank_index_);
 
         return *this;
     }
 
     ~Vector()
     {
-        delete [] data_;
+        free_data_();
 
         destroy_fields_();
     }
@@ -699,7 +795,7 @@ public:
     {
         if (to == VECTOR_MAX_CAPACITY + 1)
         {
-            to = capacity_;
+            to = size_;
         }
 
         std::cout << std::endl;
@@ -742,7 +838,7 @@ public:
         return size_ == 0;
     }
 
-    bool size() const
+    size_t size() const
     {
         return size_;
     }
@@ -752,6 +848,11 @@ public:
         return VECTOR_MAX_CAPACITY;
     }
 
+    Allocator *get_allocator() const
+    {
+        return alloc_;
+    }
+
     size_t capacity() const
     {
         return booked_capacity_;
@@ -759,6 +860,8 @@ public:
 
     void reserve(size_t reserved_capacity)
     {
+        invalidate_rank_index_();
+
         if (reserved_capacity <= capacity_)
         {
             if (booked_capacity_ < reserved_capacity)
@@ -772,10 +875,7 @@ public:
         size_t actual_capacity = 0;
         uint8_t *new_data = vector_realloc_(reserved_capacity, &actual_capacity);
 
-        if ((data_ != const_cast<uint8_t *> (reinterpret_cast<const uint8_t *> (UNINIT_PTR))) && data_is_valid_())
-        {
-            delete [] data_;
-        }
+        free_data_();
 
         data_            = new_data;
         booked_capacity_ = reserved_capacity;
@@ -784,6 +884,8 @@ public:
 
     void shrink_to_fit()
     {
+        invalidate_rank_index_();
+
         if (capacity_ - size_ <= BITS_IN_BYTE)
         {
             return;
@@ -792,19 +894,26 @@ public:
         size_t actual_capacity = 0;
         uint8_t *new_data = vector_realloc_(size_, &actual_capacity);
 
-        if ((data_ != const_cast<uint8_t *> (reinterpret_cast<const uint8_t *> (UNINIT_PTR))) && data_is_valid_())
-        {
-            delete [] data_;
-        }
+        free_data_();
 
         data_            = new_data;
         booked_capacity_ = size_;
         capacity_        = actual_capacity;
     }
+
+    // bytes shrink_to_fit() would give back
+    size_t spare_bytes() const
+    {
+        return bits_to_bytes_quantity(capacity_) - bits_to_covering_bytes_quantity(size_);
+    }
 //-------------------------------Element access----------------------------------
     const BitReference operator [](size_t index) const
     {
-        return const_cast<Vector<bool> *> (this)->operator[](index);
+        assert(index < booked_capacity_);
+
+        BitsAndBytes shift(index);
+
+        return BitReference(data_ + shift.bytes_, MAX_SHIFT - shift.bits_);
     }
 
     BitReference operator [](size_t index)
@@ -813,12 +922,12 @@ public:
 
         BitsAndBytes shift(index);
 
-        return BitReference(data_ + shift.bytes_, MAX_SHIFT - shift.bits_);
+        return BitReference(data_ + shift.bytes_, MAX_SHIFT - shift.bits_, this);
     }
 
     const BitReference at(size_t index) const
     {
-        return const_cast<Vector<bool> *> (this)->at(index);
+        return const_cast<Vector *> (this)->at(index);
     }
 
     BitReference at(size_t index)
@@ -831,9 +940,16 @@ public:
         std::cerr << "ERROR(BitVector " << this << "): attempt to obtain value out of bounds" << std::endl;
     }
 
+    bool test(size_t index) const
+    {
+        assert(index < size_);
+
+        return get_bit_value_(index);
+    }
+
     bool front() const
     {
-        return const_cast<Vector<bool> *> (this)->front();
+        return get_bit_value_(0);
     }
 
     bool front()
@@ -843,7 +959,7 @@ public:
 
     bool back() const
     {
-        return const_cast<Vector<bool> *> (this)->back();
+        return get_bit_value_(size_ - 1);
     }
 
     bool back()
@@ -853,11 +969,15 @@ public:
 
     const uint8_t *data() const
     {
-        return const_cast<const uint8_t *> (const_cast<Vector<bool> *> (this)->data());
+        return data_;
     }
 
+    // writes through the raw bytes cannot be seen, so the rank index is dropped when they are
+    // handed out and has to be built again after the last such write
     uint8_t *data()
     {
+        invalidate_rank_index_();
+
         return data_;
     }
 
@@ -947,10 +1067,336 @@ public:
         return crend();
     }
 
+//----------------------------------Word access------------------------------------
+    size_t words_quantity() const
+    {
+        return bits_to_words_quantity(size_);
+    }
+
+    // word_index-th group of 64 bits, bit (word_index * 64 + i) at position 63 - i, tail past size_ zeroed
+    uint64_t get_word(size_t word_index) const
+    {
+        assert(word_index < words_quantity());
+
+        size_t first_bit = word_index << BITS_TO_WORDS_OFFSET;
+        size_t bytes_quantity = bits_to_covering_bytes_quantity(size_) - (first_bit >> 3);
+
+        return load_bit_word(data_ + (first_bit >> 3), bytes_quantity) & leading_bits_mask(size_ - first_bit);
+    }
+
+    void set_word(size_t word_index, uint64_t word)
+    {
+        assert(word_index < words_quantity());
+
+        invalidate_rank_index_();
+
+        size_t first_bit = word_index << BITS_TO_WORDS_OFFSET;
+        size_t bytes_quantity = bits_to_covering_bytes_quantity(size_) - (first_bit >> 3);
+
+        store_bit_word(data_ + (first_bit >> 3), bytes_quantity, word);
+    }
+//--------------------------------Population count---------------------------------
+    size_t count() const
+    {
+        return count(0, size_);
+    }
+
+    // set bits in [from, to); with threads_quantity > 1 big ranges are split between threads
+    size_t count(size_t from, size_t to, size_t threads_quantity = 1) const
+    {
+        assert(from <= to);
+        assert(to <= size_);
+
+        return popcount_bit_range_parallel(data_, from, to, threads_quantity);
+    }
+
+    bool all() const
+    {
+        return all(0, size_);
+    }
+
+    bool all(size_t from, size_t to) const
+    {
+        assert(from <= to);
+        assert(to <= size_);
+
+        return find_forward_(from, false) >= to;
+    }
+
+    bool any() const
+    {
+        return any(0, size_);
+    }
+
+    bool any(size_t from, size_t to) const
+    {
+        assert(from <= to);
+        assert(to <= size_);
+
+        return find_forward_(from, true) < to;
+    }
+
+    bool none() const
+    {
+        return !any();
+    }
+
+    bool none(size_t from, size_t to) const
+    {
+        return !any(from, to);
+    }
+//--------------------------------Rank and select----------------------------------
+    // builds the rank/select directory; any write drops it again, including one through a
+    // reference or iterator taken before the build
+    void build_rank_index()
+    {
+        rank_index_.build(data_, size_);
+    }
+
+    bool has_rank_index() const
+    {
+        return rank_index_.is_built();
+    }
+
+    size_t rank1(size_t index) const
+    {
+        assert(index <= size_);
+
+        if (rank_index_.is_built())
+        {
+            return rank_index_.rank1(index);
+        }
+
+        return count(0, index);
+    }
+
+    size_t rank0(size_t index) const
+    {
+        return index - rank1(index);
+    }
+
+    // position of the k-th set bit (counting from zero), size() if there are not enough set bits
+    size_t select1(size_t k) const
+    {
+        if (rank_index_.is_built())
+        {
+            return rank_index_.select1(k);
+        }
+
+        size_t words = words_quantity();
+        for (size_t word = 0; word < words; ++word)
+        {
+            uint64_t cur_word = get_word(word);
+            size_t ones_in_word = static_cast<size_t> (std::popcount(cur_word));
+            if (k < ones_in_word)
+            {
+                return (word << BITS_TO_WORDS_OFFSET) + select_in_bit_word(cur_word, k);
+            }
+
+            k -= ones_in_word;
+        }
+
+        return size_;
+    }
+//----------------------------------Bit search-------------------------------------
+    // all of these return size() when there is no such bit
+    size_t find_first() const
+    {
+        return find_forward_(0, true);
+    }
+
+    size_t find_next(size_t pos) const
+    {
+        return find_forward_(pos + 1, true);
+    }
+
+    size_t find_last() const
+    {
+        return find_backward_(size_, true);
+    }
+
+    size_t find_prev(size_t pos) const
+    {
+        return find_backward_(pos, true);
+    }
+
+    size_t find_first_zero() const
+    {
+        return find_forward_(0, false);
+    }
+
+    size_t find_next_zero(size_t pos) const
+    {
+        return find_forward_(pos + 1, false);
+    }
+
+    size_t find_last_zero() const
+    {
+        return find_backward_(size_, false);
+    }
+
+    size_t find_prev_zero(size_t pos) const
+    {
+        return find_backward_(pos, false);
+    }
+
+    template<typename Visitor>
+    void for_each_set_bit(Visitor visitor) const
+    {
+        size_t words = words_quantity();
+        for (size_t word = 0; word < words; ++word)
+        {
+            uint64_t cur_word = get_word(word);
+            while (cur_word != 0)
+            {
+                size_t index_in_word = static_cast<size_t> (std::countl_zero(cur_word));
+                visitor((word << BITS_TO_WORDS_OFFSET) + index_in_word);
+
+                cur_word ^= bit_in_word_mask(index_in_word);
+            }
+        }
+    }
+
+    SetBitRange set_bits() const
+    {
+        return SetBitRange(this);
+    }
+//----------------------------------Algorithms-------------------------------------
+    // bool values are indistinguishable, so sorting and partitioning only need the number of ones
+    void sort()
+    {
+        sort(std::less<bool>());
+    }
+
+    template<typename Compare>
+    void sort(Compare compare)
+    {
+        size_t ones = count();
+        invalidate_rank_index_();
+
+        if (compare(true, false))
+        {
+            fill_bits_(0, ones, true);
+            fill_bits_(ones, size_, false);
+        }
+        else
+        {
+            fill_bits_(0, size_ - ones, false);
+            fill_bits_(size_ - ones, size_, true);
+        }
+    }
+
+    template<typename Predicate>
+    Iterator partition(Predicate predicate)
+    {
+        bool true_goes_first  = predicate(true);
+        bool false_goes_first = predicate(false);
+        if (true_goes_first == false_goes_first)
+        {
+            return true_goes_first ? end() : begin();
+        }
+
+        size_t ones = count();
+        sort([=](bool left, bool right)
+             {
+                 return true_goes_first ? left > right : left < right;
+             });
+
+        return begin() + static_cast<difference_type> (true_goes_first ? ones : size_ - ones);
+    }
+
+    void reverse()
+    {
+        size_t words = words_quantity();
+        if (words == 0)
+        {
+            return;
+        }
+
+        uint64_t *reversed_words = new uint64_t[words];
+        for (size_t word = 0; word < words; ++word)
+        {
+            reversed_words[word] = reverse_bit_word(get_word(words - 1 - word));
+        }
+
+        // the zero tail of the last word is in front now, shift it away
+        ptrdiff_t padding = static_cast<ptrdiff_t> ((words << BITS_TO_WORDS_OFFSET) - size_);
+        for (size_t word = 0; word < words; ++word)
+        {
+            set_word(word, funnel_bit_word(reversed_words, words, static_cast<ptrdiff_t> (word << BITS_TO_WORDS_OFFSET) + padding));
+        }
+
+        delete [] reversed_words;
+    }
+
+    // same as std::rotate: middle becomes the first bit, returns the new position of the first bit
+    Iterator rotate(ConstIterator middle)
+    {
+        ptrdiff_t shift = middle - cbegin();
+        if ((shift < 0) || (shift > static_cast<ptrdiff_t> (size_)))
+        {
+            std::cerr << "ERROR(Vector<bool> " << this << "): attempt to rotate around out of bounds" << std::endl;
+
+            return end();
+        }
+
+        size_t words = words_quantity();
+        if ((shift == 0) || (static_cast<size_t> (shift) == size_))
+        {
+            return begin() + static_cast<difference_type> (size_ - shift);
+        }
+
+        uint64_t *old_words = new uint64_t[words];
+        for (size_t word = 0; word < words; ++word)
+        {
+            old_words[word] = get_word(word);
+        }
+
+        ptrdiff_t tail_length = static_cast<ptrdiff_t> (size_) - shift;
+        for (size_t word = 0; word < words; ++word)
+        {
+            ptrdiff_t first_bit = static_cast<ptrdiff_t> (word << BITS_TO_WORDS_OFFSET);
+
+            set_word(word, funnel_bit_word(old_words, words, first_bit + shift) |
+                           funnel_bit_word(old_words, words, first_bit - tail_length));
+        }
+
+        delete [] old_words;
+
+        return begin() + tail_length;
+    }
 //----------------------------------Modifiers--------------------------------------
+    void fill(size_t from, size_t to, bool value)
+    {
+        assert(from <= to);
+        assert(to <= size_);
+
+        invalidate_rank_index_();
+
+        fill_bits_(from, to, value);
+    }
+
+    void set(size_t index, bool value = true)
+    {
+        assert(index < size_);
+
+        invalidate_rank_index_();
+
+        set_bit_value_(index, value);
+    }
+
+    void reset(size_t index)
+    {
+        set(index, false);
+    }
+
     void clear()
     {
+        invalidate_rank_index_();
+
         size_ = 0;
+
+        shrink_if_sparse_();
     }
 
     // BitIterator<false> insert(BitIterator<true> pos, bool value)
@@ -964,7 +1410,7 @@ public:
             return end();
         }
 
-        reserve(size_ + 1);
+        reserve(size_ < capacity_ ? size_ + 1 : calculate_enough_capacity_(size_ + 1));
         init_elements_(size_, size_ + 1);
         BitsAndBytes data_copy_to_index(index + 1);
         BitsAndBytes data_copy_from_index(index);
@@ -1002,6 +1448,8 @@ public:
 
         --size_;
 
+        shrink_if_sparse_();
+
         return begin() + index;
     }
 
@@ -1024,6 +1472,8 @@ public:
 
     void resize(size_t new_size, bool value = false)
     {
+        invalidate_rank_index_();
+
         if (new_size > VECTOR_MAX_CAPACITY)
         {
             std::cerr << "ERROR(BitVector " << this << "): resizing requires too much memory" << std::endl;
@@ -1035,6 +1485,8 @@ public:
         {
             size_ = new_size;
 
+            shrink_if_sparse_();
+
             return;
         }
 
@@ -1052,30 +1504,90 @@ public:
         }
 
         size_t actual_capacity = 0;
-        uint8_t *new_data = vector_realloc_(new_size, &actual_capacity);
+        uint8_t *new_data = vector_realloc_(calculate_enough_capacity_(new_size), &actual_capacity);
 
-        if ((data_ != const_cast<uint8_t *> (reinterpret_cast<const uint8_t *> (UNINIT_PTR))) && data_is_valid_())
-        {
-            delete [] data_;
-        }
+        free_data_();
 
         data_            = new_data;
         capacity_        = actual_capacity;
+        init_elements_(size_, new_size, value);
         booked_capacity_ = new_size;
         size_            = new_size;
+    }
 
+    // takes ownership of a new[]-allocated buffer of capacity bits without copying it;
+    // LSB_FIRST bytes are turned into the native order in place. On false the buffer is
+    // left untouched and stays with the caller
+    bool adopt(uint8_t *buffer, size_t size, size_t capacity, BitOrder order = BitOrder::MSB_FIRST)
+    {
+        assert(buffer != nullptr);
+
+        if ((size > capacity) || ((capacity & MAX_SHIFT) != 0))
+        {
+            std::cerr << "ERROR(Vector<bool> " << this << "): adopted buffer has invalid size or capacity" << std::endl;
+
+            return false;
+        }
+
+        invalidate_rank_index_();
+
+        free_data_();
+
+        if (order == BitOrder::LSB_FIRST)
+        {
+            reverse_bits_in_bytes(buffer, bits_to_covering_bytes_quantity(size));
+        }
+
+        alloc_           = default_allocator();                                     // a new[] buffer is heap memory whatever we used before
+        data_            = buffer;
+        capacity_        = capacity;
+        booked_capacity_ = capacity;
+        size_            = size;
+
+        return true;
+    }
+
+    // hands the buffer (to be freed with delete []) over to the caller and leaves the vector empty,
+    // only heap buffers can leave the vector
+    uint8_t *release(BitOrder order = BitOrder::MSB_FIRST)
+    {
+        invalidate_rank_index_();
+
+        if ((data_ == const_cast<uint8_t *> (reinterpret_cast<const uint8_t *> (UNINIT_PTR))) || !data_is_valid_())
+        {
+            return nullptr;
+        }
+        if (alloc_ != default_allocator())
+        {
+            std::cerr << "ERROR(Vector<bool> " << this << "): cannot release a buffer of a custom allocator" << std::endl;
+
+            return nullptr;
+        }
+
+        uint8_t *buffer = data_;
+        if (order == BitOrder::LSB_FIRST)
+        {
+            reverse_bits_in_bytes(buffer, bits_to_covering_bytes_quantity(size_));
+        }
+
+        data_            = reinterpret_cast<uint8_t *> (const_cast<char *> (UNINIT_PTR));
+        capacity_        = 0;
+        booked_capacity_ = 0;
+        size_            = 0;
+
+        return buffer;
     }
 
-    void swap(Vector<bool> &other)
+    void swap(Vector &other) noexcept
     {
-        Vector<bool> temp = my_move(other);
+        Vector temp = my_move(other);
         other = my_move(*this);
         *this = my_move(temp);
     }
 
 private:
 //--------------------------------Utilitary functions------------------------------
-    bool get_bit_value_(size_t where)
+    bool get_bit_value_(size_t where) const
     {
         BitsAndBytes pos(where);
         BitReference where_to_get(data_ + pos.bytes_, MAX_SHIFT - pos.bits_);
@@ -1092,10 +1604,34 @@ private:
 
     void init_elements_(size_t from, size_t to, const bool value = false)
     {
-        for (size_t index = from; index < to; ++index)
+        fill_bits_(from, to, value);
+    }
+
+    void fill_bits_(size_t from, size_t to, bool value)
+    {
+        if (from >= to)
         {
-            set_bit_value_(index, value);
+            return;
+        }
+
+        size_t first_byte = from >> BITS_TO_BYTES_OFFSET;
+        size_t last_byte  = (to - 1) >> BITS_TO_BYTES_OFFSET;
+
+        uint8_t head_mask = static_cast<uint8_t> (0xFF >> (from & MAX_SHIFT));
+        uint8_t tail_mask = static_cast<uint8_t> (0xFF << (MAX_SHIFT - ((to - 1) & MAX_SHIFT)));
+        if (first_byte == last_byte)
+        {
+            head_mask &= tail_mask;
+        }
+
+        data_[first_byte] = value ? (data_[first_byte] | head_mask) : (data_[first_byte] & ~head_mask);
+        if (first_byte == last_byte)
+        {
+            return;
         }
+
+        std::memset(data_ + first_byte + 1, value ? 0xFF : 0x00, last_byte - first_byte - 1);
+        data_[last_byte] = value ? (data_[last_byte] | tail_mask) : (data_[last_byte] & ~tail_mask);
     }
 
     // void copy_data_(BitIterator<false> dest, BitIterator<true> src, size_t quantity)
@@ -1122,22 +1658,134 @@ private:
         }
     }
 
+    // the policy works in bytes, a byte being the smallest piece of bits that is allocated
+    size_t calculate_enough_capacity_(size_t required_size) const
+    {
+        size_t required_bytes = bits_to_covering_bytes_quantity(required_size);
+        size_t bytes = GrowthPolicy::next_capacity(bits_to_bytes_quantity(capacity_), required_bytes, *alloc_, 1);
+        assert(bytes >= required_bytes);
+
+        return bytes << BITS_TO_BYTES_OFFSET;
+    }
+
+    // only policies with shrink_capacity() ever give memory back on their own, in bytes as well
+    void shrink_if_sparse_()
+    {
+        if constexpr (requires { GrowthPolicy::shrink_capacity(capacity_, size_); })
+        {
+            size_t bytes     = bits_to_bytes_quantity(capacity_);
+            size_t new_bytes = GrowthPolicy::shrink_capacity(bytes, bits_to_covering_bytes_quantity(size_));
+            if (new_bytes >= bytes)
+            {
+                return;
+            }
+
+            size_t actual_capacity = 0;
+            uint8_t *new_data = vector_realloc_(new_bytes << BITS_TO_BYTES_OFFSET, &actual_capacity);
+
+            free_data_();
+
+            data_            = new_data;
+            capacity_        = actual_capacity;
+            booked_capacity_ = std::min(booked_capacity_, actual_capacity);
+        }
+    }
+
     uint8_t *vector_realloc_(size_t new_capacity, size_t *actual_capacity)
     {
         assert(actual_capacity != nullptr);
 
         *actual_capacity = round_to_eight_multiple(new_capacity);
-        uint8_t *new_data = new uint8_t[bits_to_bytes_quantity(*actual_capacity)];
+        uint8_t *new_data = allocate_data_(*actual_capacity);
 
-        // BitIterator<true>  data_copy_from(this, data_);
-        // BitIterator<false> data_copy_to(this, new_data);
-        Iterator data_copy_from(this, data_);
-        ConstIterator data_copy_to(this, new_data);
-        copy_data_(data_copy_to, data_copy_from, size_);
+        // whole bytes, the part of the new buffer past them starts out zeroed
+        size_t new_bytes    = bits_to_bytes_quantity(*actual_capacity);
+        size_t copied_bytes = std::min(bits_to_covering_bytes_quantity(size_), new_bytes);
+        copy_block(new_data, data_, copied_bytes);
+        uninitialized_fill_row(new_data + copied_bytes, new_bytes - copied_bytes, uint8_t(0));
 
         return new_data;
     }
 
+    uint8_t *allocate_data_(size_t capacity)
+    {
+        return reinterpret_cast<uint8_t *> (alloc_->allocate(bits_to_bytes_quantity(capacity)));
+    }
+
+    void free_data_()
+    {
+        if ((data_ != const_cast<uint8_t *> (reinterpret_cast<const uint8_t *> (UNINIT_PTR))) && data_is_valid_())
+        {
+            alloc_->deallocate(reinterpret_cast<char *> (data_), bits_to_bytes_quantity(capacity_));
+        }
+    }
+
+    uint64_t get_search_word_(size_t word_index, bool value) const
+    {
+        uint64_t word = get_word(word_index);
+
+        return value ? word : ~word & leading_bits_mask(size_ - (word_index << BITS_TO_WORDS_OFFSET));
+    }
+
+    // first bit equal to value in [from, size_)
+    size_t find_forward_(size_t from, bool value) const
+    {
+        if (from >= size_)
+        {
+            return size_;
+        }
+
+        size_t words = words_quantity();
+        size_t word  = from >> BITS_TO_WORDS_OFFSET;
+        uint64_t cur_word = get_search_word_(word, value) & ~leading_bits_mask(from & WORD_BITS_MASK);
+        while (cur_word == 0)
+        {
+            if (++word == words)
+            {
+                return size_;
+            }
+
+            cur_word = get_search_word_(word, value);
+        }
+
+        return (word << BITS_TO_WORDS_OFFSET) + static_cast<size_t> (std::countl_zero(cur_word));
+    }
+
+    // last bit equal to value in [0, to)
+    size_t find_backward_(size_t to, bool value) const
+    {
+        if (to > size_)
+        {
+            to = size_;
+        }
+        if (to == 0)
+        {
+            return size_;
+        }
+
+        size_t word = (to - 1) >> BITS_TO_WORDS_OFFSET;
+        uint64_t cur_word = get_search_word_(word, value) & leading_bits_mask(to - (word << BITS_TO_WORDS_OFFSET));
+        while (cur_word == 0)
+        {
+            if (word-- == 0)
+            {
+                return size_;
+            }
+
+            cur_word = get_search_word_(word, value);
+        }
+
+        return (word << BITS_TO_WORDS_OFFSET) + WORD_BITS_MASK - static_cast<size_t> (std::countr_zero(cur_word));
+    }
+
+    void invalidate_rank_index_()
+    {
+        if (rank_index_.is_built())
+        {
+            rank_index_.reset();
+        }
+    }
+
     bool data_is_valid_() const
     {
         return (data_ != const_cast<uint8_t *> (reinterpret_cast<const uint8_t *> (DESTR_PTR))) &&
@@ -1189,14 +1837,17 @@ private:
 
 private:
 //-----------------------------------Variables-------------------------------------
-    static constexpr uint64_t VECTOR_MAX_CAPACITY       = 1024;
-    static constexpr uint64_t DEFAULT_RESIZE_MULTIPLIER = 2;
+    // in bits, so rounding up to whole bytes cannot overflow
+    static constexpr uint64_t VECTOR_MAX_CAPACITY = static_cast<uint64_t> (std::numeric_limits<std::ptrdiff_t>::max());
 
     size_t capacity_        = 0;
     size_t booked_capacity_ = 0;
     size_t size_            = 0;
 
+    Allocator *alloc_ = default_allocator();
     uint8_t *data_ = reinterpret_cast<uint8_t *> (const_cast<char *> (UNINIT_PTR));
+
+    BitRankIndex rank_index_;
 };
 
 
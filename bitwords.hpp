@@ -0,0 +1,176 @@
+#ifndef BIT_WORDS_HPP
+#define BIT_WORDS_HPP
+
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+
+const size_t BITS_IN_WORD         = 64;
+const size_t BYTES_IN_WORD        = 8;
+const size_t WORD_BITS_MASK       = 63;
+const size_t BITS_TO_WORDS_OFFSET = 6;
+
+
+// order of bits inside a byte: Vector<bool> is MSB_FIRST, columnar formats are LSB_FIRST
+enum class BitOrder
+{
+    MSB_FIRST,
+    LSB_FIRST
+};
+
+
+inline size_t bits_to_words_quantity(size_t bits_quantity)
+{
+    return (bits_quantity + WORD_BITS_MASK) >> BITS_TO_WORDS_OFFSET;
+}
+
+inline size_t bits_to_covering_bytes_quantity(size_t bits_quantity)
+{
+    return (bits_quantity + 7) >> 3;
+}
+
+// Vector<bool> keeps bit 0 in the highest bit of byte 0, so a word is read big-endian:
+// bit i of the bitmap lands at position (63 - i % 64) of word i / 64
+inline uint64_t bit_in_word_mask(size_t index_in_word)
+{
+    return 0x1ull << (WORD_BITS_MASK - index_in_word);
+}
+
+inline uint64_t leading_bits_mask(size_t bits_quantity)
+{
+    if (bits_quantity == 0)
+    {
+        return 0;
+    }
+    if (bits_quantity >= BITS_IN_WORD)
+    {
+        return ~0ull;
+    }
+
+    return ~0ull << (BITS_IN_WORD - bits_quantity);
+}
+
+inline uint64_t load_bit_word(const uint8_t *bytes, size_t bytes_quantity)
+{
+    if (bytes_quantity >= BYTES_IN_WORD)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes, BYTES_IN_WORD);
+
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            word = __builtin_bswap64(word);
+        }
+
+        return word;
+    }
+
+    uint64_t word = 0;
+    for (size_t byte_index = 0; byte_index < bytes_quantity; ++byte_index)
+    {
+        word |= static_cast<uint64_t> (bytes[byte_index]) << (WORD_BITS_MASK - 7 - (byte_index << 3));
+    }
+
+    return word;
+}
+
+inline void store_bit_word(uint8_t *bytes, size_t bytes_quantity, uint64_t word)
+{
+    if (bytes_quantity >= BYTES_IN_WORD)
+    {
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            word = __builtin_bswap64(word);
+        }
+
+        std::memcpy(bytes, &word, BYTES_IN_WORD);
+
+        return;
+    }
+
+    for (size_t byte_index = 0; byte_index < bytes_quantity; ++byte_index)
+    {
+        bytes[byte_index] = static_cast<uint8_t> (word >> (WORD_BITS_MASK - 7 - (byte_index << 3)));
+    }
+}
+
+inline uint64_t reverse_bits_in_word_bytes(uint64_t word)
+{
+    word = ((word >> 1) & 0x5555555555555555ull) | ((word & 0x5555555555555555ull) << 1);
+    word = ((word >> 2) & 0x3333333333333333ull) | ((word & 0x3333333333333333ull) << 2);
+
+    return ((word >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((word & 0x0F0F0F0F0F0F0F0Full) << 4);
+}
+
+inline uint64_t reverse_bit_word(uint64_t word)
+{
+    return __builtin_bswap64(reverse_bits_in_word_bytes(word));
+}
+
+// switches bytes between MSB_FIRST and LSB_FIRST in place
+inline void reverse_bits_in_bytes(uint8_t *bytes, size_t bytes_quantity)
+{
+    size_t byte_index = 0;
+    for (; byte_index + BYTES_IN_WORD <= bytes_quantity; byte_index += BYTES_IN_WORD)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes + byte_index, BYTES_IN_WORD);
+
+        word = reverse_bits_in_word_bytes(word);
+        std::memcpy(bytes + byte_index, &word, BYTES_IN_WORD);
+    }
+
+    for (; byte_index < bytes_quantity; ++byte_index)
+    {
+        bytes[byte_index] = static_cast<uint8_t> (reverse_bits_in_word_bytes(bytes[byte_index]));
+    }
+}
+
+// 64 bits of a word array starting at an arbitrary (even negative) bit position,
+// bits outside of the array read as zeroes
+inline uint64_t funnel_bit_word(const uint64_t *words, size_t words_quantity, ptrdiff_t first_bit)
+{
+    if (first_bit <= -static_cast<ptrdiff_t> (BITS_IN_WORD))
+    {
+        return 0;
+    }
+
+    ptrdiff_t word  = first_bit >> BITS_TO_WORDS_OFFSET;
+    size_t    shift = static_cast<size_t> (first_bit) & WORD_BITS_MASK;
+
+    uint64_t high = ((word >= 0) && (static_cast<size_t> (word) < words_quantity)) ? words[word] : 0;
+    if (shift == 0)
+    {
+        return high;
+    }
+
+    uint64_t low = ((word + 1 >= 0) && (static_cast<size_t> (word + 1) < words_quantity)) ? words[word + 1] : 0;
+
+    return (high << shift) | (low >> (BITS_IN_WORD - shift));
+}
+
+// position (counted from the most significant bit) of the rank-th set bit of the word
+inline size_t select_in_bit_word(uint64_t word, size_t rank)
+{
+#ifdef __BMI2__
+    size_t from_lowest = static_cast<size_t> (std::popcount(word)) - 1 - rank;
+
+    return static_cast<size_t> (std::countl_zero(_pdep_u64(0x1ull << from_lowest, word)));
+#else
+    for (; rank > 0; --rank)
+    {
+        word &= ~bit_in_word_mask(static_cast<size_t> (std::countl_zero(word)));
+    }
+
+    return static_cast<size_t> (std::countl_zero(word));
+#endif
+}
+
+
+#endif
@@ -0,0 +1,431 @@
+#ifndef BLOOM_FILTER_HPP
+#define BLOOM_FILTER_HPP
+
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <numbers>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "bitvector.hpp"
+#include "specialvalues.hpp"
+
+
+const size_t BLOOM_BATCH_SIZE = 16;                      // keys whose cache lines are prefetched together
+
+
+// murmur3 finalizer: std::hash of integers is the identity, the filters need all 64 bits mixed
+inline uint64_t mix_bloom_hash(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+// maps a 32-bit value uniformly onto [0, range) without a division
+inline uint64_t reduce_to_range(uint32_t value, uint64_t range)
+{
+    return (static_cast<uint64_t> (value) * range) >> 32;
+}
+
+
+//-----------------------------------Class BloomFilter-------------------------------
+// Classic Bloom filter over the packed bits of a Vector<bool>, k probes by double hashing
+class BloomFilter
+{
+public:
+//---------------------------------------------------------------------------------
+    BloomFilter(size_t expected_keys, size_t bits_per_key = DEFAULT_BITS_PER_KEY, size_t hashes_quantity = 0)
+      : bits_quantity_  (std::max<size_t> (expected_keys * bits_per_key, BITS_IN_WORD)),
+        hashes_quantity_(hashes_quantity != 0 ? hashes_quantity : optimal_hashes_quantity_(bits_per_key)),
+        bits_           (bits_quantity_, false)
+    {}
+//---------------------------------------------------------------------------------
+    size_t bits_quantity() const
+    {
+        return bits_quantity_;
+    }
+
+    size_t hashes_quantity() const
+    {
+        return hashes_quantity_;
+    }
+
+    const Vector<bool> &bits() const
+    {
+        return bits_;
+    }
+//---------------------------------------------------------------------------------
+    void insert_hash(uint64_t hash)
+    {
+        hash = mix_bloom_hash(hash);
+
+        uint32_t probe = static_cast<uint32_t> (hash);
+        uint32_t step  = static_cast<uint32_t> (hash >> 32) | 0x1;
+        for (size_t index = 0; index < hashes_quantity_; ++index)
+        {
+            bits_.set(reduce_to_range(probe, bits_quantity_));
+            probe += step;
+        }
+    }
+
+    bool contains_hash(uint64_t hash) const
+    {
+        hash = mix_bloom_hash(hash);
+
+        uint32_t probe = static_cast<uint32_t> (hash);
+        uint32_t step  = static_cast<uint32_t> (hash >> 32) | 0x1;
+        for (size_t index = 0; index < hashes_quantity_; ++index)
+        {
+            if (!bits_.test(reduce_to_range(probe, bits_quantity_)))
+            {
+                return false;
+            }
+
+            probe += step;
+        }
+
+        return true;
+    }
+
+    template<typename Key, typename Hash = std::hash<Key>>
+    void insert(const Key &key)
+    {
+        insert_hash(Hash()(key));
+    }
+
+    template<typename Key, typename Hash = std::hash<Key>>
+    bool contains(const Key &key) const
+    {
+        return contains_hash(Hash()(key));
+    }
+
+    template<typename Key, typename Hash = std::hash<Key>>
+    void insert_many(const Key *keys, size_t quantity)
+    {
+        assert((keys != nullptr) || (quantity == 0));
+
+        uint64_t hashes[BLOOM_BATCH_SIZE] = {};
+        for (size_t first = 0; first < quantity; first += BLOOM_BATCH_SIZE)
+        {
+            size_t batch = std::min(BLOOM_BATCH_SIZE, quantity - first);
+            prefetch_batch_(keys + first, batch, hashes, Hash());
+
+            for (size_t index = 0; index < batch; ++index)
+            {
+                insert_hash(hashes[index]);
+            }
+        }
+    }
+
+    // results[i] tells whether keys[i] may be in the set
+    template<typename Key, typename Hash = std::hash<Key>>
+    void contains_many(const Key *keys, size_t quantity, bool *results) const
+    {
+        assert((keys != nullptr) || (quantity == 0));
+        assert((results != nullptr) || (quantity == 0));
+
+        uint64_t hashes[BLOOM_BATCH_SIZE] = {};
+        for (size_t first = 0; first < quantity; first += BLOOM_BATCH_SIZE)
+        {
+            size_t batch = std::min(BLOOM_BATCH_SIZE, quantity - first);
+            prefetch_batch_(keys + first, batch, hashes, Hash());
+
+            for (size_t index = 0; index < batch; ++index)
+            {
+                results[first + index] = contains_hash(hashes[index]);
+            }
+        }
+    }
+
+    BloomFilter &operator |=(const BloomFilter &other)
+    {
+        if ((bits_quantity_ != other.bits_quantity_) || (hashes_quantity_ != other.hashes_quantity_))
+        {
+            std::cerr << "ERROR(BloomFilter " << this << "): attempt to unite filters of different shapes" << std::endl;
+
+            return *this;
+        }
+
+        size_t words = bits_.words_quantity();
+        for (size_t word = 0; word < words; ++word)
+        {
+            bits_.set_word(word, bits_.get_word(word) | other.bits_.get_word(word));
+        }
+
+        return *this;
+    }
+
+    void clear()
+    {
+        bits_.fill(0, bits_quantity_, false);
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    static size_t optimal_hashes_quantity_(size_t bits_per_key)
+    {
+        size_t hashes_quantity = static_cast<size_t> (std::lround(static_cast<double> (bits_per_key) * std::numbers::ln2));
+
+        return std::max<size_t> (hashes_quantity, 1);
+    }
+
+    // hashes a batch and touches the cache line of every probe before any of them is used
+    template<typename Key, typename Hash>
+    void prefetch_batch_(const Key *keys, size_t quantity, uint64_t *hashes, Hash hasher) const
+    {
+        for (size_t index = 0; index < quantity; ++index)
+        {
+            hashes[index] = hasher(keys[index]);
+
+            uint64_t hash  = mix_bloom_hash(hashes[index]);
+            uint32_t probe = static_cast<uint32_t> (hash);
+            uint32_t step  = static_cast<uint32_t> (hash >> 32) | 0x1;
+            for (size_t hash_index = 0; hash_index < hashes_quantity_; ++hash_index)
+            {
+                __builtin_prefetch(bits_.data() + (reduce_to_range(probe, bits_quantity_) >> 3));
+                probe += step;
+            }
+        }
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    static constexpr size_t DEFAULT_BITS_PER_KEY = 10;
+
+    size_t bits_quantity_   = 0;
+    size_t hashes_quantity_ = 0;
+
+    Vector<bool> bits_;
+};
+
+
+//-------------------------------Class BlockedBloomFilter----------------------------
+// Split-block Bloom filter: a key picks one 256-bit block (half of a cache line, aligned) and
+// sets one bit in each of the first k of its eight 32-bit lanes, so a lookup is a single miss
+// and the lane masks are computed for all lanes at once
+class BlockedBloomFilter
+{
+public:
+//---------------------------------------------------------------------------------
+    BlockedBloomFilter(size_t expected_keys, size_t bits_per_key = DEFAULT_BITS_PER_KEY, size_t hashes_quantity = LANES_IN_BLOCK)
+      : blocks_quantity_((std::max<size_t> (expected_keys * bits_per_key, BITS_IN_BLOCK) + BITS_IN_BLOCK - 1) / BITS_IN_BLOCK),
+        hashes_quantity_(std::min<size_t> (std::max<size_t> (hashes_quantity, 1), LANES_IN_BLOCK)),
+        lanes_(new (std::align_val_t(BLOCK_ALIGNMENT)) uint32_t[blocks_quantity_ * LANES_IN_BLOCK]{})
+    {}
+
+    BlockedBloomFilter(const BlockedBloomFilter &other)
+      : blocks_quantity_(other.blocks_quantity_),
+        hashes_quantity_(other.hashes_quantity_),
+        lanes_(new (std::align_val_t(BLOCK_ALIGNMENT)) uint32_t[blocks_quantity_ * LANES_IN_BLOCK])
+    {
+        std::memcpy(lanes_, other.lanes_, blocks_quantity_ * LANES_IN_BLOCK * sizeof(uint32_t));
+    }
+
+    BlockedBloomFilter &operator =(const BlockedBloomFilter &other) = delete;
+
+    ~BlockedBloomFilter()
+    {
+        ::operator delete[](lanes_, std::align_val_t(BLOCK_ALIGNMENT));
+
+        lanes_           = const_cast<uint32_t *> (reinterpret_cast<const uint32_t *> (DESTR_PTR));
+        blocks_quantity_ = POISONED_UINT64_T;
+    }
+//---------------------------------------------------------------------------------
+    size_t bits_quantity() const
+    {
+        return blocks_quantity_ * BITS_IN_BLOCK;
+    }
+
+    size_t hashes_quantity() const
+    {
+        return hashes_quantity_;
+    }
+//---------------------------------------------------------------------------------
+    void insert_hash(uint64_t hash)
+    {
+        hash = mix_bloom_hash(hash);
+
+        uint32_t *block = lanes_ + block_index_(hash) * LANES_IN_BLOCK;
+        uint32_t key    = static_cast<uint32_t> (hash);
+
+#ifdef __AVX2__
+        __m256i *vector_block = reinterpret_cast<__m256i *> (block);
+        _mm256_store_si256(vector_block, _mm256_or_si256(_mm256_load_si256(vector_block), make_mask_avx2_(key)));
+#else
+        uint32_t masks[LANES_IN_BLOCK] = {};
+        make_mask_(key, masks);
+        for (size_t lane = 0; lane < LANES_IN_BLOCK; ++lane)
+        {
+            block[lane] |= masks[lane];
+        }
+#endif
+    }
+
+    bool contains_hash(uint64_t hash) const
+    {
+        hash = mix_bloom_hash(hash);
+
+        const uint32_t *block = lanes_ + block_index_(hash) * LANES_IN_BLOCK;
+        uint32_t key          = static_cast<uint32_t> (hash);
+
+#ifdef __AVX2__
+        return _mm256_testc_si256(_mm256_load_si256(reinterpret_cast<const __m256i *> (block)), make_mask_avx2_(key));
+#else
+        uint32_t masks[LANES_IN_BLOCK] = {};
+        make_mask_(key, masks);
+
+        uint32_t missing = 0;
+        for (size_t lane = 0; lane < LANES_IN_BLOCK; ++lane)
+        {
+            missing |= masks[lane] & ~block[lane];
+        }
+
+        return missing == 0;
+#endif
+    }
+
+    template<typename Key, typename Hash = std::hash<Key>>
+    void insert(const Key &key)
+    {
+        insert_hash(Hash()(key));
+    }
+
+    template<typename Key, typename Hash = std::hash<Key>>
+    bool contains(const Key &key) const
+    {
+        return contains_hash(Hash()(key));
+    }
+
+    template<typename Key, typename Hash = std::hash<Key>>
+    void insert_many(const Key *keys, size_t quantity)
+    {
+        assert((keys != nullptr) || (quantity == 0));
+
+        uint64_t hashes[BLOOM_BATCH_SIZE] = {};
+        for (size_t first = 0; first < quantity; first += BLOOM_BATCH_SIZE)
+        {
+            size_t batch = std::min(BLOOM_BATCH_SIZE, quantity - first);
+            prefetch_batch_(keys + first, batch, hashes, Hash());
+
+            for (size_t index = 0; index < batch; ++index)
+            {
+                insert_hash(hashes[index]);
+            }
+        }
+    }
+
+    template<typename Key, typename Hash = std::hash<Key>>
+    void contains_many(const Key *keys, size_t quantity, bool *results) const
+    {
+        assert((keys != nullptr) || (quantity == 0));
+        assert((results != nullptr) || (quantity == 0));
+
+        uint64_t hashes[BLOOM_BATCH_SIZE] = {};
+        for (size_t first = 0; first < quantity; first += BLOOM_BATCH_SIZE)
+        {
+            size_t batch = std::min(BLOOM_BATCH_SIZE, quantity - first);
+            prefetch_batch_(keys + first, batch, hashes, Hash());
+
+            for (size_t index = 0; index < batch; ++index)
+            {
+                results[first + index] = contains_hash(hashes[index]);
+            }
+        }
+    }
+
+    BlockedBloomFilter &operator |=(const BlockedBloomFilter &other)
+    {
+        if ((blocks_quantity_ != other.blocks_quantity_) || (hashes_quantity_ != other.hashes_quantity_))
+        {
+            std::cerr << "ERROR(BlockedBloomFilter " << this << "): attempt to unite filters of different shapes" << std::endl;
+
+            return *this;
+        }
+
+        size_t lanes_quantity = blocks_quantity_ * LANES_IN_BLOCK;
+        for (size_t lane = 0; lane < lanes_quantity; ++lane)
+        {
+            lanes_[lane] |= other.lanes_[lane];
+        }
+
+        return *this;
+    }
+
+    void clear()
+    {
+        std::memset(lanes_, 0, blocks_quantity_ * LANES_IN_BLOCK * sizeof(uint32_t));
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    size_t block_index_(uint64_t hash) const
+    {
+        return reduce_to_range(static_cast<uint32_t> (hash >> 32), blocks_quantity_);
+    }
+
+    // lane i gets bit (key * SALT[i]) >> 27, lanes past hashes_quantity_ stay empty
+    void make_mask_(uint32_t key, uint32_t *masks) const
+    {
+        for (size_t lane = 0; lane < hashes_quantity_; ++lane)
+        {
+            masks[lane] = 0x1u << ((key * SALTS[lane]) >> 27);
+        }
+    }
+
+#ifdef __AVX2__
+    __m256i make_mask_avx2_(uint32_t key) const
+    {
+        const __m256i salts = _mm256_setr_epi32(SALTS[0], SALTS[1], SALTS[2], SALTS[3],
+                                                SALTS[4], SALTS[5], SALTS[6], SALTS[7]);
+        const __m256i lane_numbers = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+        __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int> (key)), salts), 27);
+        __m256i masks  = _mm256_sllv_epi32(_mm256_set1_epi32(1), shifts);
+        __m256i used   = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int> (hashes_quantity_)), lane_numbers);
+
+        return _mm256_and_si256(masks, used);
+    }
+#endif
+
+    template<typename Key, typename Hash>
+    void prefetch_batch_(const Key *keys, size_t quantity, uint64_t *hashes, Hash hasher) const
+    {
+        for (size_t index = 0; index < quantity; ++index)
+        {
+            hashes[index] = hasher(keys[index]);
+
+            __builtin_prefetch(lanes_ + block_index_(mix_bloom_hash(hashes[index])) * LANES_IN_BLOCK);
+        }
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    static constexpr size_t DEFAULT_BITS_PER_KEY = 10;
+    static constexpr size_t LANES_IN_BLOCK       = 8;
+    static constexpr size_t BITS_IN_BLOCK        = LANES_IN_BLOCK * 32;
+    static constexpr size_t BLOCK_ALIGNMENT      = 64;
+
+    static constexpr uint32_t SALTS[LANES_IN_BLOCK] = {0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+                                                       0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u};
+
+    size_t blocks_quantity_ = 0;
+    size_t hashes_quantity_ = 0;
+
+    uint32_t *lanes_ = nullptr;
+};
+
+
+#endif
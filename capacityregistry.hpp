@@ -0,0 +1,251 @@
+#ifndef CAPACITY_REGISTRY_HPP
+#define CAPACITY_REGISTRY_HPP
+
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "myforward.hpp"
+
+
+// Process-wide list of containers whose spare capacity may be handed back when memory runs
+// short, reached through capacity_registry(). A memory-pressure hook calls trim(bytes) and
+// the containers give back what they hold beyond their size until bytes have been released:
+// first those nobody has touched since the previous trim, then any that are not in use right
+// now. A container its owner is working on is skipped, the registry never waits for one
+class CapacityRegistry
+{
+    friend CapacityRegistry *capacity_registry();
+
+public:
+    // a registered container; the owner holds mutex_ while working on it, the registry only
+    // ever tries to take it
+    class Client
+    {
+        friend class CapacityRegistry;
+
+    public:
+        Client() = default;
+
+        Client(const Client &other) = delete;
+        Client &operator =(const Client &other) = delete;
+
+        virtual ~Client()
+        {
+            assert(!registered_);
+        }
+
+    protected:
+        // both run with mutex_ held
+        virtual size_t spare_bytes() const = 0;
+        virtual void trim() = 0;
+
+        std::mutex mutex_;
+        bool touched_ = false;                  // used since the registry last looked at it
+
+    private:
+        Client *prev_ = nullptr;
+        Client *next_ = nullptr;
+        bool registered_ = false;
+    };
+//---------------------------------------------------------------------------------
+    CapacityRegistry(const CapacityRegistry &other) = delete;
+    CapacityRegistry &operator =(const CapacityRegistry &other) = delete;
+//---------------------------------------------------------------------------------
+    void add(Client *client)
+    {
+        assert((client != nullptr) && !client->registered_);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        client->prev_ = nullptr;
+        client->next_ = clients_;
+        if (clients_ != nullptr)
+        {
+            clients_->prev_ = client;
+        }
+
+        clients_ = client;
+        client->registered_ = true;
+        ++clients_quantity_;
+    }
+
+    void remove(Client *client)
+    {
+        assert((client != nullptr) && client->registered_);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (client->prev_ != nullptr)
+        {
+            client->prev_->next_ = client->next_;
+        }
+        else
+        {
+            clients_ = client->next_;
+        }
+
+        if (client->next_ != nullptr)
+        {
+            client->next_->prev_ = client->prev_;
+        }
+
+        client->prev_ = nullptr;
+        client->next_ = nullptr;
+        client->registered_ = false;
+        --clients_quantity_;
+    }
+
+    // bytes actually released, which falls short of bytes when too little is spare or idle
+    size_t trim(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        size_t released = 0;
+        for (bool idle_only : {true, false})
+        {
+            for (Client *client = clients_; (client != nullptr) && (released < bytes); client = client->next_)
+            {
+                std::unique_lock<std::mutex> client_lock(client->mutex_, std::try_to_lock);
+                if (!client_lock.owns_lock())
+                {
+                    continue;
+                }
+
+                if (idle_only && client->touched_)
+                {
+                    client->touched_ = false;           // idle if still untouched by the next trim
+
+                    continue;
+                }
+
+                size_t spare = client->spare_bytes();
+                if (spare == 0)
+                {
+                    continue;
+                }
+
+                client->trim();
+                released += spare - client->spare_bytes();
+            }
+        }
+
+        return released;
+    }
+
+    // spare bytes of the containers that are not in use right now
+    size_t spare_bytes()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        size_t spare = 0;
+        for (Client *client = clients_; client != nullptr; client = client->next_)
+        {
+            std::unique_lock<std::mutex> client_lock(client->mutex_, std::try_to_lock);
+            if (client_lock.owns_lock())
+            {
+                spare += client->spare_bytes();
+            }
+        }
+
+        return spare;
+    }
+
+    size_t clients_quantity()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        return clients_quantity_;
+    }
+
+private:
+//---------------------------------------------------------------------------------
+    CapacityRegistry() = default;
+
+private:
+//-----------------------------------Variables-------------------------------------
+    std::mutex mutex_;
+
+    Client *clients_ = nullptr;
+    size_t clients_quantity_ = 0;
+};
+
+
+// never destroyed, like slab_allocator(): static containers may unregister while the process exits
+inline CapacityRegistry *capacity_registry()
+{
+    static CapacityRegistry *registry = new CapacityRegistry();
+
+    return registry;
+}
+
+
+// A Vector (or Vector<bool>) the registry may trim. Every use goes through lock(), which keeps
+// the registry away from the vector for as long as the returned Access lives
+template<typename VectorType>
+class TrimmableVector : public CapacityRegistry::Client
+{
+public:
+    class Access
+    {
+    public:
+        explicit Access(TrimmableVector &owner)
+          : lock_(owner.mutex_),
+            vector_(&owner.vector_)
+        {
+            owner.touched_ = true;
+        }
+//---------------------------------------------------------------------------------
+        VectorType &operator *() const
+        {
+            return *vector_;
+        }
+
+        VectorType *operator ->() const
+        {
+            return vector_;
+        }
+
+    private:
+//-----------------------------------Variables-------------------------------------
+        std::unique_lock<std::mutex> lock_;
+        VectorType *vector_ = nullptr;
+    };
+//---------------------------------------------------------------------------------
+    template<typename... ArgsT>
+    explicit TrimmableVector(ArgsT &&... args)
+      : vector_(my_forward<ArgsT>(args)...)
+    {
+        capacity_registry()->add(this);
+    }
+
+    ~TrimmableVector()
+    {
+        capacity_registry()->remove(this);
+    }
+//---------------------------------------------------------------------------------
+    Access lock()
+    {
+        return Access(*this);
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    size_t spare_bytes() const override
+    {
+        return vector_.spare_bytes();
+    }
+
+    void trim() override
+    {
+        vector_.shrink_to_fit();
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    VectorType vector_;
+};
+
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef CHUNK_ALLOC_HPP
+#define CHUNK_ALLOC_HPP
+
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include "bigarray.hpp"
+#include "dynamicalloc.hpp"
+#include "specialvalues.hpp"
+
+
+// Bump-pointer arena over a BigArray: allocate() moves a pointer, deallocate() does nothing
+// and everything comes back at once with reset() or, for nested scopes, rewind() to a
+// mark(). Requests that do not fit into the buffer go to the upstream allocator and are
+// freed by the same reset()/rewind(). Containers allocating here must not be used after
+// their memory was reset, though destroying them afterwards is fine
+class ChunkAlloc : public Allocator, protected BigArray
+{
+    struct OverflowBlock
+    {
+        OverflowBlock *next = nullptr;
+        size_t bytes = 0;
+    };
+
+public:
+    struct Mark
+    {
+        size_t offset = 0;
+        OverflowBlock *overflow = nullptr;
+    };
+
+    // rewinds the arena to where it was when the scope was opened
+    class Scope
+    {
+    public:
+//---------------------------------------------------------------------------------
+        Scope(ChunkAlloc &alloc)
+          : alloc_(&alloc),
+            mark_(alloc.mark())
+        {}
+
+        Scope(const Scope &other) = delete;
+        Scope &operator =(const Scope &other) = delete;
+
+        ~Scope()
+        {
+            alloc_->rewind(mark_);
+
+            alloc_ = const_cast<ChunkAlloc *> (reinterpret_cast<const ChunkAlloc *> (DESTR_PTR));
+        }
+
+    private:
+//-----------------------------------Variables-------------------------------------
+        ChunkAlloc *alloc_ = nullptr;
+        Mark mark_;
+    };
+//---------------------------------------------------------------------------------
+    ChunkAlloc(uint64_t capacity = DEFAULT_CAPACITY, Allocator *upstream = default_allocator())
+      : BigArray(capacity),
+        top_(raw_data_),
+        upstream_(upstream)
+    {
+        assert(upstream != nullptr);
+    }
+
+    ~ChunkAlloc()
+    {
+        reset();
+
+        top_      = const_cast<char *> (DESTR_PTR);
+        upstream_ = nullptr;
+    }
+//---------------------------------------------------------------------------------
+    char *allocate(size_t bytes) override
+    {
+        size_t rounded = round_up_(bytes > 0 ? bytes : 1);
+        if (rounded <= static_cast<size_t> (end_ - top_))
+        {
+            char *result = top_;
+            top_ += rounded;
+
+            return result;
+        }
+
+        size_t block_bytes = OVERFLOW_HEADER_SIZE + rounded;
+        char *block = upstream_->allocate(block_bytes);
+
+        OverflowBlock *header = new (block) OverflowBlock;
+        header->next  = overflow_;
+        header->bytes = block_bytes;
+        overflow_ = header;
+
+        return block + OVERFLOW_HEADER_SIZE;
+    }
+
+    void deallocate(char * /* data */, size_t /* bytes */) override
+    {}
+
+    size_t usable_size(size_t bytes) const override
+    {
+        return round_up_(bytes > 0 ? bytes : 1);
+    }
+
+    Mark mark() const
+    {
+        return Mark{static_cast<size_t> (top_ - raw_data_), overflow_};
+    }
+
+    void rewind(const Mark &mark)
+    {
+        assert(mark.offset <= used());
+
+        top_ = raw_data_ + mark.offset;
+        while (overflow_ != mark.overflow)
+        {
+            assert(overflow_ != nullptr);
+
+            OverflowBlock *next = overflow_->next;
+            upstream_->deallocate(reinterpret_cast<char *> (overflow_), overflow_->bytes);
+            overflow_ = next;
+        }
+    }
+
+    void reset()
+    {
+        rewind(Mark());
+    }
+//---------------------------------------------------------------------------------
+    size_t capacity() const
+    {
+        return static_cast<size_t> (end_ - raw_data_);
+    }
+
+    size_t used() const
+    {
+        return static_cast<size_t> (top_ - raw_data_);
+    }
+
+    bool has_overflow() const
+    {
+        return overflow_ != nullptr;
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    static size_t round_up_(size_t bytes)
+    {
+        return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    static constexpr size_t ALIGNMENT            = alignof(std::max_align_t);
+    static constexpr size_t OVERFLOW_HEADER_SIZE = (sizeof(OverflowBlock) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+    char *top_ = nullptr;
+    OverflowBlock *overflow_ = nullptr;
+
+    Allocator *upstream_ = nullptr;
+};
+
+
+#endif
@@ -0,0 +1,341 @@
+#ifndef CHUNK_GENERATOR_HPP
+#define CHUNK_GENERATOR_HPP
+
+
+#include <cassert>
+#include <cerrno>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <unistd.h>
+#include "vector.hpp"
+
+
+// Coroutine that yields the same one or two Vector<Type> buffers over and over, refilled
+// between the steps; a range-for over it sees every chunk of a stream exactly once. The
+// yielded Vector stays valid until the loop advances, the consumer may change its contents
+template<typename Type>
+class ChunkGenerator
+{
+public:
+    struct promise_type
+    {
+        ChunkGenerator get_return_object()
+        {
+            return ChunkGenerator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always yield_value(Vector<Type> &chunk) noexcept
+        {
+            current = &chunk;
+
+            return {};
+        }
+
+        void return_void()
+        {}
+
+        void unhandled_exception()
+        {
+            exception = std::current_exception();
+        }
+
+        Vector<Type> *current = nullptr;
+        std::exception_ptr exception;
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    class Iterator
+    {
+    public:
+        using value_type      = Vector<Type>;
+        using difference_type = std::ptrdiff_t;
+//---------------------------------------------------------------------------------
+        Iterator() = default;
+
+        explicit Iterator(Handle handle)
+          : handle_(handle)
+        {}
+//---------------------------------------------------------------------------------
+        Vector<Type> &operator *() const
+        {
+            return *handle_.promise().current;
+        }
+
+        Vector<Type> *operator ->() const
+        {
+            return handle_.promise().current;
+        }
+
+        Iterator &operator ++()
+        {
+            resume_(handle_);
+
+            return *this;
+        }
+
+        void operator ++(int)
+        {
+            ++*this;
+        }
+
+        bool operator ==(std::default_sentinel_t) const
+        {
+            return (handle_ == nullptr) || handle_.done();
+        }
+
+    private:
+//-----------------------------------Variables-------------------------------------
+        Handle handle_ = nullptr;
+    };
+//---------------------------------------------------------------------------------
+    explicit ChunkGenerator(Handle handle)
+      : handle_(handle)
+    {}
+
+    ChunkGenerator(const ChunkGenerator &other) = delete;
+    ChunkGenerator &operator =(const ChunkGenerator &other) = delete;
+
+    ChunkGenerator(ChunkGenerator &&other)
+      : handle_(std::exchange(other.handle_, nullptr))
+    {}
+
+    ChunkGenerator &operator =(ChunkGenerator &&other)
+    {
+        std::swap(handle_, other.handle_);
+
+        return *this;
+    }
+
+    // stops the producer wherever it is, a read running ahead is waited for
+    ~ChunkGenerator()
+    {
+        if (handle_ != nullptr)
+        {
+            handle_.destroy();
+        }
+
+        handle_ = nullptr;
+    }
+//---------------------------------------------------------------------------------
+    Iterator begin()
+    {
+        resume_(handle_);
+
+        return Iterator(handle_);
+    }
+
+    std::default_sentinel_t end() const
+    {
+        return std::default_sentinel;
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    static void resume_(Handle handle)
+    {
+        assert((handle != nullptr) && !handle.done());
+
+        handle.resume();
+        if (handle.promise().exception != nullptr)
+        {
+            std::rethrow_exception(std::exchange(handle.promise().exception, nullptr));
+        }
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    Handle handle_ = nullptr;
+};
+
+
+// Chunks of up to chunk_size elements written by fill(Type *destination, size_t capacity),
+// which returns how many it wrote and 0 at the end of the stream. The buffers are sized once,
+// so no chunk after the first reallocates; with double_buffered the next chunk is filled by one
+// reader thread, started once for the whole stream, while the consumer works on the current one
+template<typename Type, typename Fill>
+ChunkGenerator<Type> generate_chunks(Fill fill, size_t chunk_size, bool double_buffered = false)
+{
+    Vector<Type> buffers[2];
+    if (chunk_size == 0)
+    {
+        std::cerr << "ERROR(generate_chunks): chunk size must not be 0" << std::endl;
+
+        co_return;
+    }
+
+    size_t buffers_quantity = double_buffered ? 2 : 1;
+    for (size_t buffer = 0; buffer < buffers_quantity; ++buffer)
+    {
+        buffers[buffer].resize(chunk_size);
+    }
+
+    // the elements fill() is about to overwrite are not initialised again, unless Type needs it
+    auto fill_buffer = [&fill, chunk_size](Vector<Type> &buffer)
+    {
+        if constexpr (requires { buffer.resize_for_overwrite(chunk_size); })
+        {
+            buffer.resize_for_overwrite(chunk_size);
+        }
+        else
+        {
+            buffer.resize(chunk_size);
+        }
+
+        size_t filled = fill(buffer.data(), chunk_size);
+        assert(filled <= chunk_size);
+
+        buffer.resize(filled);
+
+        return filled;
+    };
+
+    size_t current = 0;
+    size_t filled  = fill_buffer(buffers[current]);
+    if (!double_buffered)
+    {
+        while (filled > 0)
+        {
+            co_yield buffers[current];
+
+            filled = fill_buffer(buffers[current]);
+        }
+
+        co_return;
+    }
+
+    // handed over under mutex: the generator asks for a buffer to be filled, the reader
+    // reports when it is; no lock is held across a co_yield
+    std::mutex mutex;
+    std::condition_variable_any changed;
+    bool requested = false;
+    bool ready     = false;
+    size_t target      = 0;
+    size_t next_filled = 0;
+    std::exception_ptr next_exception;
+
+    // declared after the state it uses, so it is stopped and joined first when the consumer
+    // abandons the generator; a read running at that moment is waited for
+    std::jthread reader([&](std::stop_token stop)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (changed.wait(lock, stop, [&] { return requested; }))
+        {
+            requested = false;
+            size_t buffer = target;
+            lock.unlock();
+
+            size_t result = 0;
+            std::exception_ptr exception;
+            try
+            {
+                result = fill_buffer(buffers[buffer]);
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+
+            lock.lock();
+            next_filled    = result;
+            next_exception = exception;
+            ready          = true;
+            changed.notify_all();
+        }
+    });
+
+    while (filled > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            target    = current ^ 1;
+            ready     = false;
+            requested = true;
+        }
+        changed.notify_all();
+
+        co_yield buffers[current];
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return ready; });
+        }
+
+        if (next_exception != nullptr)
+        {
+            std::rethrow_exception(next_exception);
+        }
+
+        current ^= 1;
+        filled   = next_filled;
+    }
+}
+
+// raw Type values read from fd, which is left open; reads are repeated until a chunk is full,
+// so only the last one is short, and bytes of an incomplete last element are reported
+template<typename Type>
+ChunkGenerator<Type> read_chunks(int fd, size_t chunk_size, bool double_buffered = false)
+{
+    static_assert(std::is_trivially_copyable_v<Type>, "read_chunks copies the bytes of the file into the elements");
+
+    auto fill = [fd](Type *destination, size_t capacity) -> size_t
+    {
+        char  *bytes  = reinterpret_cast<char *> (destination);
+        size_t wanted = capacity * sizeof(Type);
+        size_t got    = 0;
+        while (got < wanted)
+        {
+            ssize_t result = read(fd, bytes + got, wanted - got);
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                std::cerr << "ERROR(read_chunks): read failed: " << std::strerror(errno) << std::endl;
+
+                break;
+            }
+            if (result == 0)
+            {
+                break;
+            }
+
+            got += static_cast<size_t> (result);
+        }
+
+        if (got % sizeof(Type) != 0)
+        {
+            std::cerr << "ERROR(read_chunks): " << got % sizeof(Type) << " trailing bytes do not make an element" << std::endl;
+        }
+
+        return got / sizeof(Type);
+    };
+
+    return generate_chunks<Type>(fill, chunk_size, double_buffered);
+}
+
+
+#endif
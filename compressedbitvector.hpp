@@ -0,0 +1,1307 @@
+#ifndef COMPRESSED_BIT_VECTOR_HPP
+#define COMPRESSED_BIT_VECTOR_HPP
+
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include "bitvector.hpp"
+#include "bitwords.hpp"
+
+
+// Roaring-style bitmap: the universe is cut into chunks of 2^16 bits, each non-empty chunk
+// is kept as a sorted array of positions, a list of runs or 1024 plain words, whichever is smaller
+class CompressedBitVector
+{
+    static constexpr size_t   CHUNK_BITS_OFFSET = 16;
+    static constexpr size_t   CHUNK_BITS        = 1ull << CHUNK_BITS_OFFSET;
+    static constexpr size_t   CHUNK_WORDS       = CHUNK_BITS / BITS_IN_WORD;
+    static constexpr size_t   CHUNK_LOW_MASK    = CHUNK_BITS - 1;
+    static constexpr size_t   ARRAY_MAX_SIZE    = 4096;
+    static constexpr uint32_t NO_BIT            = CHUNK_BITS;
+
+    enum class ContainerType
+    {
+        ARRAY,
+        BITMAP,
+        RUN
+    };
+
+    enum class Operation
+    {
+        OR,
+        AND,
+        XOR,
+        AND_NOT
+    };
+
+    class Container
+    {
+    public:
+//---------------------------------------------------------------------------------
+        Container(size_t key = 0)
+          : key_(key)
+        {}
+
+        Container(const Container &other)
+          : key_            (other.key_),
+            type_           (other.type_),
+            cardinality_    (other.cardinality_),
+            values_quantity_(other.values_quantity_),
+            values_capacity_(other.values_quantity_)
+        {
+            if (other.values_ != nullptr)
+            {
+                values_ = new uint16_t[values_capacity_ > 0 ? values_capacity_ : 1];
+                std::memcpy(values_, other.values_, values_quantity_ * sizeof(uint16_t));
+            }
+            if (other.words_ != nullptr)
+            {
+                words_ = new uint64_t[CHUNK_WORDS];
+                std::memcpy(words_, other.words_, CHUNK_WORDS * sizeof(uint64_t));
+            }
+        }
+
+        Container(Container &&other)
+        {
+            swap(other);
+        }
+
+        Container &operator =(const Container &other)
+        {
+            Container copy(other);
+            swap(copy);
+
+            return *this;
+        }
+
+        Container &operator =(Container &&other)
+        {
+            swap(other);
+
+            return *this;
+        }
+
+        ~Container()
+        {
+            delete [] values_;
+            delete [] words_;
+
+            values_ = nullptr;
+            words_  = nullptr;
+        }
+
+        void swap(Container &other)
+        {
+            std::swap(key_,             other.key_);
+            std::swap(type_,            other.type_);
+            std::swap(cardinality_,     other.cardinality_);
+            std::swap(values_,          other.values_);
+            std::swap(values_quantity_, other.values_quantity_);
+            std::swap(values_capacity_, other.values_capacity_);
+            std::swap(words_,           other.words_);
+        }
+//---------------------------------------------------------------------------------
+        size_t key() const
+        {
+            return key_;
+        }
+
+        ContainerType type() const
+        {
+            return type_;
+        }
+
+        size_t cardinality() const
+        {
+            return cardinality_;
+        }
+
+        size_t memory_usage() const
+        {
+            return sizeof(Container) + values_capacity_ * sizeof(uint16_t) + (words_ != nullptr ? CHUNK_WORDS * sizeof(uint64_t) : 0);
+        }
+
+        const uint64_t *words() const
+        {
+            return words_;
+        }
+
+        bool contains(uint32_t low) const
+        {
+            switch (type_)
+            {
+                case ContainerType::ARRAY:
+                    return std::binary_search(values_, values_ + values_quantity_, static_cast<uint16_t> (low));
+                case ContainerType::BITMAP:
+                    return (words_[low >> BITS_TO_WORDS_OFFSET] & bit_in_word_mask(low & WORD_BITS_MASK)) != 0;
+                case ContainerType::RUN:
+                {
+                    size_t run = find_run_(low);
+                    return (run < runs_quantity_()) && (values_[2 * run] <= low);
+                }
+            }
+
+            return false;
+        }
+
+        bool add(uint32_t low)
+        {
+            make_mutable_();
+
+            if (type_ == ContainerType::BITMAP)
+            {
+                uint64_t &word = words_[low >> BITS_TO_WORDS_OFFSET];
+                uint64_t mask  = bit_in_word_mask(low & WORD_BITS_MASK);
+                if ((word & mask) != 0)
+                {
+                    return false;
+                }
+
+                word |= mask;
+                ++cardinality_;
+
+                return true;
+            }
+
+            uint16_t *position = std::lower_bound(values_, values_ + values_quantity_, static_cast<uint16_t> (low));
+            if ((position != values_ + values_quantity_) && (*position == low))
+            {
+                return false;
+            }
+
+            if (values_quantity_ == ARRAY_MAX_SIZE)
+            {
+                uint64_t *words = new uint64_t[CHUNK_WORDS];
+                to_words(words);
+                words[low >> BITS_TO_WORDS_OFFSET] |= bit_in_word_mask(low & WORD_BITS_MASK);
+
+                set_bitmap_(words, cardinality_ + 1);
+
+                return true;
+            }
+
+            size_t index = static_cast<size_t> (position - values_);
+            reserve_values_(values_quantity_ + 1);
+            std::memmove(values_ + index + 1, values_ + index, (values_quantity_ - index) * sizeof(uint16_t));
+            values_[index] = static_cast<uint16_t> (low);
+
+            ++values_quantity_;
+            ++cardinality_;
+
+            return true;
+        }
+
+        bool remove(uint32_t low)
+        {
+            if (!contains(low))
+            {
+                return false;
+            }
+
+            make_mutable_();
+
+            if (type_ == ContainerType::BITMAP)
+            {
+                words_[low >> BITS_TO_WORDS_OFFSET] &= ~bit_in_word_mask(low & WORD_BITS_MASK);
+                --cardinality_;
+
+                if (cardinality_ <= ARRAY_MAX_SIZE)
+                {
+                    uint64_t *words = words_;
+                    words_ = nullptr;
+
+                    set_array_(words, cardinality_);
+                    delete [] words;
+                }
+
+                return true;
+            }
+
+            uint16_t *position = std::lower_bound(values_, values_ + values_quantity_, static_cast<uint16_t> (low));
+            std::memmove(position, position + 1, (values_ + values_quantity_ - position - 1) * sizeof(uint16_t));
+
+            --values_quantity_;
+            --cardinality_;
+
+            return true;
+        }
+
+        // first set bit at or after low, NO_BIT if there is none
+        uint32_t next_set(uint32_t low) const
+        {
+            if (low >= CHUNK_BITS)
+            {
+                return NO_BIT;
+            }
+
+            switch (type_)
+            {
+                case ContainerType::ARRAY:
+                {
+                    const uint16_t *position = std::lower_bound(values_, values_ + values_quantity_, static_cast<uint16_t> (low));
+                    return position == values_ + values_quantity_ ? NO_BIT : *position;
+                }
+                case ContainerType::BITMAP:
+                    return next_set_in_words_(words_, low);
+                case ContainerType::RUN:
+                {
+                    size_t run = find_run_(low);
+                    if (run == runs_quantity_())
+                    {
+                        return NO_BIT;
+                    }
+
+                    return std::max<uint32_t> (values_[2 * run], low);
+                }
+            }
+
+            return NO_BIT;
+        }
+
+        // last set bit at or before low, NO_BIT if there is none
+        uint32_t prev_set(uint32_t low) const
+        {
+            switch (type_)
+            {
+                case ContainerType::ARRAY:
+                {
+                    const uint16_t *position = std::upper_bound(values_, values_ + values_quantity_, static_cast<uint16_t> (low));
+                    return position == values_ ? NO_BIT : *(position - 1);
+                }
+                case ContainerType::BITMAP:
+                {
+                    size_t word = low >> BITS_TO_WORDS_OFFSET;
+                    uint64_t cur_word = words_[word] & leading_bits_mask((low & WORD_BITS_MASK) + 1);
+                    while (cur_word == 0)
+                    {
+                        if (word-- == 0)
+                        {
+                            return NO_BIT;
+                        }
+
+                        cur_word = words_[word];
+                    }
+
+                    return static_cast<uint32_t> ((word << BITS_TO_WORDS_OFFSET) + WORD_BITS_MASK - std::countr_zero(cur_word));
+                }
+                case ContainerType::RUN:
+                {
+                    size_t run = find_run_(low);
+                    if ((run < runs_quantity_()) && (values_[2 * run] <= low))
+                    {
+                        return low;
+                    }
+
+                    return run == 0 ? NO_BIT : values_[2 * run - 1];
+                }
+            }
+
+            return NO_BIT;
+        }
+
+        template<typename Visitor>
+        void for_each(Visitor visitor, size_t base) const
+        {
+            switch (type_)
+            {
+                case ContainerType::ARRAY:
+                    for (size_t index = 0; index < values_quantity_; ++index)
+                    {
+                        visitor(base + values_[index]);
+                    }
+                    break;
+                case ContainerType::BITMAP:
+                    for (size_t word = 0; word < CHUNK_WORDS; ++word)
+                    {
+                        uint64_t cur_word = words_[word];
+                        while (cur_word != 0)
+                        {
+                            size_t index_in_word = static_cast<size_t> (std::countl_zero(cur_word));
+                            visitor(base + (word << BITS_TO_WORDS_OFFSET) + index_in_word);
+
+                            cur_word ^= bit_in_word_mask(index_in_word);
+                        }
+                    }
+                    break;
+                case ContainerType::RUN:
+                    for (size_t run = 0; run < runs_quantity_(); ++run)
+                    {
+                        for (size_t low = values_[2 * run]; low <= values_[2 * run + 1]; ++low)
+                        {
+                            visitor(base + low);
+                        }
+                    }
+                    break;
+            }
+        }
+
+        void to_words(uint64_t *words) const
+        {
+            assert(words != nullptr);
+
+            switch (type_)
+            {
+                case ContainerType::ARRAY:
+                    std::memset(words, 0, CHUNK_WORDS * sizeof(uint64_t));
+                    for (size_t index = 0; index < values_quantity_; ++index)
+                    {
+                        words[values_[index] >> BITS_TO_WORDS_OFFSET] |= bit_in_word_mask(values_[index] & WORD_BITS_MASK);
+                    }
+                    break;
+                case ContainerType::BITMAP:
+                    std::memcpy(words, words_, CHUNK_WORDS * sizeof(uint64_t));
+                    break;
+                case ContainerType::RUN:
+                    std::memset(words, 0, CHUNK_WORDS * sizeof(uint64_t));
+                    for (size_t run = 0; run < runs_quantity_(); ++run)
+                    {
+                        fill_words_(words, values_[2 * run], values_[2 * run + 1] + 1ull);
+                    }
+                    break;
+            }
+        }
+
+        // rebuilds the container from 1024 words in the smallest of the three representations
+        void from_words(const uint64_t *words)
+        {
+            assert(words != nullptr);
+
+            size_t cardinality   = 0;
+            size_t runs_quantity = 0;
+            uint64_t prev_last_bit = 0;
+            for (size_t word = 0; word < CHUNK_WORDS; ++word)
+            {
+                cardinality   += std::popcount(words[word]);
+                runs_quantity += std::popcount(words[word] & ~((words[word] >> 1) | (prev_last_bit << WORD_BITS_MASK)));
+
+                prev_last_bit = words[word] & 0x1;
+            }
+
+            size_t array_bytes  = cardinality * sizeof(uint16_t);
+            size_t run_bytes    = runs_quantity * 2 * sizeof(uint16_t);
+            size_t bitmap_bytes = CHUNK_WORDS * sizeof(uint64_t);
+
+            if ((run_bytes < array_bytes) && (run_bytes < bitmap_bytes))
+            {
+                set_runs_(words, cardinality, runs_quantity);
+            }
+            else if (cardinality <= ARRAY_MAX_SIZE)
+            {
+                set_array_(words, cardinality);
+            }
+            else
+            {
+                uint64_t *words_copy = new uint64_t[CHUNK_WORDS];
+                std::memcpy(words_copy, words, CHUNK_WORDS * sizeof(uint64_t));
+
+                set_bitmap_(words_copy, cardinality);
+            }
+        }
+
+        void optimize()
+        {
+            uint64_t *words = new uint64_t[CHUNK_WORDS];
+            to_words(words);
+            from_words(words);
+
+            delete [] words;
+        }
+
+        // one chunk of (left op right), both containers must have the same key
+        static Container combine(const Container &left, const Container &right, Operation operation)
+        {
+            assert(left.key_ == right.key_);
+
+            Container result(left.key_);
+            if ((left.type_ == ContainerType::ARRAY) && (right.type_ == ContainerType::ARRAY))
+            {
+                combine_arrays_(left, right, operation, &result);
+
+                return result;
+            }
+
+            if (operation == Operation::AND)
+            {
+                if ((left.type_ == ContainerType::ARRAY) && (right.type_ == ContainerType::BITMAP))
+                {
+                    filter_array_(left, right, &result);
+
+                    return result;
+                }
+                if ((left.type_ == ContainerType::BITMAP) && (right.type_ == ContainerType::ARRAY))
+                {
+                    filter_array_(right, left, &result);
+
+                    return result;
+                }
+            }
+
+            uint64_t *left_words  = new uint64_t[CHUNK_WORDS];
+            uint64_t *right_words = new uint64_t[CHUNK_WORDS];
+            left.to_words(left_words);
+            right.to_words(right_words);
+
+            for (size_t word = 0; word < CHUNK_WORDS; ++word)
+            {
+                left_words[word] = apply_operation_(left_words[word], right_words[word], operation);
+            }
+            result.from_words(left_words);
+
+            delete [] left_words;
+            delete [] right_words;
+
+            return result;
+        }
+
+    private:
+//--------------------------------Utilitary functions------------------------------
+        static uint64_t apply_operation_(uint64_t left, uint64_t right, Operation operation)
+        {
+            switch (operation)
+            {
+                case Operation::OR:      return left | right;
+                case Operation::AND:     return left & right;
+                case Operation::XOR:     return left ^ right;
+                case Operation::AND_NOT: return left & ~right;
+            }
+
+            return 0;
+        }
+
+        static void combine_arrays_(const Container &left, const Container &right, Operation operation, Container *result)
+        {
+            uint16_t *merged = new uint16_t[left.values_quantity_ + right.values_quantity_ + 1];
+            size_t merged_quantity = 0;
+
+            size_t left_index  = 0;
+            size_t right_index = 0;
+            while ((left_index < left.values_quantity_) || (right_index < right.values_quantity_))
+            {
+                bool from_left  = (right_index == right.values_quantity_) ||
+                                  ((left_index < left.values_quantity_) && (left.values_[left_index] <= right.values_[right_index]));
+                bool from_right = (left_index == left.values_quantity_) ||
+                                  ((right_index < right.values_quantity_) && (right.values_[right_index] <= left.values_[left_index]));
+
+                uint16_t value = from_left ? left.values_[left_index] : right.values_[right_index];
+
+                bool keep = false;
+                switch (operation)
+                {
+                    case Operation::OR:      keep = true;                    break;
+                    case Operation::AND:     keep = from_left && from_right; break;
+                    case Operation::XOR:     keep = from_left != from_right; break;
+                    case Operation::AND_NOT: keep = from_left && !from_right; break;
+                }
+                if (keep)
+                {
+                    merged[merged_quantity++] = value;
+                }
+
+                left_index  += from_left;
+                right_index += from_right;
+            }
+
+            if (merged_quantity <= ARRAY_MAX_SIZE)
+            {
+                result->type_            = ContainerType::ARRAY;
+                result->values_          = merged;
+                result->values_quantity_ = static_cast<uint32_t> (merged_quantity);
+                result->values_capacity_ = static_cast<uint32_t> (left.values_quantity_ + right.values_quantity_ + 1);
+                result->cardinality_     = static_cast<uint32_t> (merged_quantity);
+
+                return;
+            }
+
+            uint64_t *words = new uint64_t[CHUNK_WORDS]{};
+            for (size_t index = 0; index < merged_quantity; ++index)
+            {
+                words[merged[index] >> BITS_TO_WORDS_OFFSET] |= bit_in_word_mask(merged[index] & WORD_BITS_MASK);
+            }
+            delete [] merged;
+
+            result->set_bitmap_(words, merged_quantity);
+        }
+
+        static void filter_array_(const Container &array, const Container &bitmap, Container *result)
+        {
+            uint16_t *filtered = new uint16_t[array.values_quantity_ + 1];
+            size_t filtered_quantity = 0;
+            for (size_t index = 0; index < array.values_quantity_; ++index)
+            {
+                filtered[filtered_quantity] = array.values_[index];
+                filtered_quantity += bitmap.contains(array.values_[index]);
+            }
+
+            result->type_            = ContainerType::ARRAY;
+            result->values_          = filtered;
+            result->values_quantity_ = static_cast<uint32_t> (filtered_quantity);
+            result->values_capacity_ = array.values_quantity_ + 1;
+            result->cardinality_     = static_cast<uint32_t> (filtered_quantity);
+        }
+
+        static uint32_t next_set_in_words_(const uint64_t *words, uint32_t low)
+        {
+            size_t word = low >> BITS_TO_WORDS_OFFSET;
+            uint64_t cur_word = words[word] & ~leading_bits_mask(low & WORD_BITS_MASK);
+            while (cur_word == 0)
+            {
+                if (++word == CHUNK_WORDS)
+                {
+                    return NO_BIT;
+                }
+
+                cur_word = words[word];
+            }
+
+            return static_cast<uint32_t> ((word << BITS_TO_WORDS_OFFSET) + std::countl_zero(cur_word));
+        }
+
+        static uint32_t next_clear_in_words_(const uint64_t *words, uint32_t low)
+        {
+            if (low >= CHUNK_BITS)
+            {
+                return NO_BIT;
+            }
+
+            size_t word = low >> BITS_TO_WORDS_OFFSET;
+            uint64_t cur_word = ~words[word] & ~leading_bits_mask(low & WORD_BITS_MASK);
+            while (cur_word == 0)
+            {
+                if (++word == CHUNK_WORDS)
+                {
+                    return NO_BIT;
+                }
+
+                cur_word = ~words[word];
+            }
+
+            return static_cast<uint32_t> ((word << BITS_TO_WORDS_OFFSET) + std::countl_zero(cur_word));
+        }
+
+        static void fill_words_(uint64_t *words, size_t from, size_t to)
+        {
+            while (from < to)
+            {
+                size_t word        = from >> BITS_TO_WORDS_OFFSET;
+                size_t word_offset = from & WORD_BITS_MASK;
+                size_t bits        = std::min(BITS_IN_WORD - word_offset, to - from);
+
+                words[word] |= leading_bits_mask(bits) >> word_offset;
+                from += bits;
+            }
+        }
+
+        size_t runs_quantity_() const
+        {
+            return values_quantity_ / 2;
+        }
+
+        // first run that ends at or after low
+        size_t find_run_(uint32_t low) const
+        {
+            size_t left  = 0;
+            size_t right = runs_quantity_();
+            while (left < right)
+            {
+                size_t middle = left + ((right - left) >> 1);
+                if (values_[2 * middle + 1] < low)
+                {
+                    left = middle + 1;
+                }
+                else
+                {
+                    right = middle;
+                }
+            }
+
+            return left;
+        }
+
+        void reserve_values_(size_t quantity)
+        {
+            if (quantity <= values_capacity_)
+            {
+                return;
+            }
+
+            size_t new_capacity = std::max<size_t> (quantity, 2 * values_capacity_);
+            uint16_t *new_values = new uint16_t[new_capacity];
+            if (values_ != nullptr)
+            {
+                std::memcpy(new_values, values_, values_quantity_ * sizeof(uint16_t));
+            }
+
+            delete [] values_;
+            values_          = new_values;
+            values_capacity_ = static_cast<uint32_t> (new_capacity);
+        }
+
+        // runs are edited through the array or bitmap form and packed back by optimize()
+        void make_mutable_()
+        {
+            if (type_ != ContainerType::RUN)
+            {
+                return;
+            }
+
+            uint64_t *words = new uint64_t[CHUNK_WORDS];
+            to_words(words);
+
+            if (cardinality_ <= ARRAY_MAX_SIZE)
+            {
+                set_array_(words, cardinality_);
+                delete [] words;
+            }
+            else
+            {
+                set_bitmap_(words, cardinality_);
+            }
+        }
+
+        void set_array_(const uint64_t *words, size_t cardinality)
+        {
+            uint16_t *values = new uint16_t[cardinality > 0 ? cardinality : 1];
+            size_t quantity = 0;
+            for (size_t word = 0; word < CHUNK_WORDS; ++word)
+            {
+                uint64_t cur_word = words[word];
+                while (cur_word != 0)
+                {
+                    size_t index_in_word = static_cast<size_t> (std::countl_zero(cur_word));
+                    values[quantity++] = static_cast<uint16_t> ((word << BITS_TO_WORDS_OFFSET) + index_in_word);
+
+                    cur_word ^= bit_in_word_mask(index_in_word);
+                }
+            }
+
+            release_();
+            type_            = ContainerType::ARRAY;
+            values_          = values;
+            values_quantity_ = static_cast<uint32_t> (cardinality);
+            values_capacity_ = static_cast<uint32_t> (cardinality > 0 ? cardinality : 1);
+            cardinality_     = static_cast<uint32_t> (cardinality);
+        }
+
+        void set_runs_(const uint64_t *words, size_t cardinality, size_t runs_quantity)
+        {
+            uint16_t *values = new uint16_t[2 * runs_quantity];
+            size_t quantity = 0;
+
+            uint32_t run_start = next_set_in_words_(words, 0);
+            while (run_start != NO_BIT)
+            {
+                uint32_t run_end = next_clear_in_words_(words, run_start);
+
+                values[quantity++] = static_cast<uint16_t> (run_start);
+                values[quantity++] = static_cast<uint16_t> ((run_end == NO_BIT ? CHUNK_BITS : run_end) - 1);
+
+                run_start = (run_end == NO_BIT) ? NO_BIT : next_set_in_words_(words, run_end);
+            }
+            assert(quantity == 2 * runs_quantity);
+
+            release_();
+            type_            = ContainerType::RUN;
+            values_          = values;
+            values_quantity_ = static_cast<uint32_t> (quantity);
+            values_capacity_ = static_cast<uint32_t> (quantity);
+            cardinality_     = static_cast<uint32_t> (cardinality);
+        }
+
+        // takes ownership of words
+        void set_bitmap_(uint64_t *words, size_t cardinality)
+        {
+            release_();
+            type_        = ContainerType::BITMAP;
+            words_       = words;
+            cardinality_ = static_cast<uint32_t> (cardinality);
+        }
+
+        void release_()
+        {
+            delete [] values_;
+            delete [] words_;
+
+            values_          = nullptr;
+            words_           = nullptr;
+            values_quantity_ = 0;
+            values_capacity_ = 0;
+        }
+
+    private:
+//----------------------------------Variables--------------------------------------
+        size_t        key_         = 0;                   // index >> CHUNK_BITS_OFFSET of every bit in the chunk
+        ContainerType type_        = ContainerType::ARRAY;
+        uint32_t      cardinality_ = 0;
+
+        uint16_t *values_          = nullptr;             // sorted positions or (first, last) pairs of runs
+        uint32_t  values_quantity_ = 0;
+        uint32_t  values_capacity_ = 0;
+
+        uint64_t *words_ = nullptr;
+    };
+
+public:
+//---------------------------------------------------------------------------------
+    CompressedBitVector() = default;
+
+    CompressedBitVector(size_t size)
+      : size_(size)
+    {}
+
+    CompressedBitVector(const Vector<bool> &other)
+      : size_(other.size())
+    {
+        uint64_t *words = new uint64_t[CHUNK_WORDS];
+
+        size_t other_words = other.words_quantity();
+        for (size_t first_word = 0; first_word < other_words; first_word += CHUNK_WORDS)
+        {
+            bool is_empty = true;
+            for (size_t word = 0; word < CHUNK_WORDS; ++word)
+            {
+                words[word] = (first_word + word < other_words) ? other.get_word(first_word + word) : 0;
+                is_empty = is_empty && (words[word] == 0);
+            }
+            if (is_empty)
+            {
+                continue;
+            }
+
+            Container container(first_word / CHUNK_WORDS);
+            container.from_words(words);
+            append_chunk_(my_move(container));
+        }
+
+        delete [] words;
+    }
+
+    CompressedBitVector(const CompressedBitVector &other)
+      : size_           (other.size_),
+        chunks_quantity_(other.chunks_quantity_),
+        chunks_capacity_(other.chunks_quantity_)
+    {
+        chunks_ = new Container[chunks_capacity_ > 0 ? chunks_capacity_ : 1];
+        for (size_t chunk = 0; chunk < chunks_quantity_; ++chunk)
+        {
+            chunks_[chunk] = other.chunks_[chunk];
+        }
+    }
+
+    CompressedBitVector(CompressedBitVector &&other)
+    {
+        swap(other);
+    }
+
+    CompressedBitVector &operator =(const CompressedBitVector &other)
+    {
+        CompressedBitVector copy(other);
+        swap(copy);
+
+        return *this;
+    }
+
+    CompressedBitVector &operator =(CompressedBitVector &&other)
+    {
+        swap(other);
+
+        return *this;
+    }
+
+    ~CompressedBitVector()
+    {
+        delete [] chunks_;
+
+        chunks_ = nullptr;
+        size_   = POISONED_UINT64_T;
+    }
+//--------------------------------Size and capacity--------------------------------
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    size_t memory_usage() const
+    {
+        size_t result = sizeof(CompressedBitVector) + (chunks_capacity_ - chunks_quantity_) * sizeof(Container);
+        for (size_t chunk = 0; chunk < chunks_quantity_; ++chunk)
+        {
+            result += chunks_[chunk].memory_usage();
+        }
+
+        return result;
+    }
+
+    void resize(size_t new_size)
+    {
+        if (new_size < size_)
+        {
+            size_t chunk = lower_chunk_(new_size >> CHUNK_BITS_OFFSET);
+            if ((chunk < chunks_quantity_) && (chunks_[chunk].key() == (new_size >> CHUNK_BITS_OFFSET)))
+            {
+                uint64_t *words = new uint64_t[CHUNK_WORDS];
+                chunks_[chunk].to_words(words);
+
+                size_t low = new_size & CHUNK_LOW_MASK;
+                words[low >> BITS_TO_WORDS_OFFSET] &= leading_bits_mask(low & WORD_BITS_MASK);
+                std::memset(words + (low >> BITS_TO_WORDS_OFFSET) + 1, 0,
+                            (CHUNK_WORDS - (low >> BITS_TO_WORDS_OFFSET) - 1) * sizeof(uint64_t));
+                chunks_[chunk].from_words(words);
+
+                delete [] words;
+
+                chunk += chunks_[chunk].cardinality() != 0;
+            }
+
+            while (chunks_quantity_ > chunk)
+            {
+                chunks_[--chunks_quantity_] = Container();
+            }
+        }
+
+        size_ = new_size;
+    }
+
+    void swap(CompressedBitVector &other)
+    {
+        std::swap(size_,            other.size_);
+        std::swap(chunks_,          other.chunks_);
+        std::swap(chunks_quantity_, other.chunks_quantity_);
+        std::swap(chunks_capacity_, other.chunks_capacity_);
+    }
+
+    // repacks every chunk into its smallest representation, runs are only formed here
+    // and by the set operations
+    void optimize()
+    {
+        for (size_t chunk = 0; chunk < chunks_quantity_; ++chunk)
+        {
+            chunks_[chunk].optimize();
+        }
+    }
+//-------------------------------Element access------------------------------------
+    bool operator [](size_t index) const
+    {
+        return test(index);
+    }
+
+    bool test(size_t index) const
+    {
+        assert(index < size_);
+
+        size_t chunk = find_chunk_(index >> CHUNK_BITS_OFFSET);
+
+        return (chunk != chunks_quantity_) && chunks_[chunk].contains(index & CHUNK_LOW_MASK);
+    }
+
+    bool at(size_t index) const
+    {
+        if (index < size_)
+        {
+            return test(index);
+        }
+
+        std::cerr << "ERROR(CompressedBitVector " << this << "): attempt to obtain value out of bounds" << std::endl;
+
+        return false;
+    }
+
+    bool front() const
+    {
+        return test(0);
+    }
+
+    bool back() const
+    {
+        return test(size_ - 1);
+    }
+//----------------------------------Modifiers--------------------------------------
+    void set(size_t index, bool value = true)
+    {
+        assert(index < size_);
+
+        if (!value)
+        {
+            reset(index);
+
+            return;
+        }
+
+        size_t key = index >> CHUNK_BITS_OFFSET;
+        size_t chunk = lower_chunk_(key);
+        if ((chunk == chunks_quantity_) || (chunks_[chunk].key() != key))
+        {
+            insert_chunk_(chunk, Container(key));
+        }
+
+        chunks_[chunk].add(index & CHUNK_LOW_MASK);
+    }
+
+    void reset(size_t index)
+    {
+        assert(index < size_);
+
+        size_t chunk = find_chunk_(index >> CHUNK_BITS_OFFSET);
+        if (chunk == chunks_quantity_)
+        {
+            return;
+        }
+
+        chunks_[chunk].remove(index & CHUNK_LOW_MASK);
+        if (chunks_[chunk].cardinality() == 0)
+        {
+            erase_chunk_(chunk);
+        }
+    }
+
+    void push_back(bool value)
+    {
+        ++size_;
+
+        if (value)
+        {
+            set(size_ - 1);
+        }
+    }
+
+    void clear()
+    {
+        resize(0);
+    }
+//--------------------------------Population count---------------------------------
+    size_t count() const
+    {
+        size_t result = 0;
+        for (size_t chunk = 0; chunk < chunks_quantity_; ++chunk)
+        {
+            result += chunks_[chunk].cardinality();
+        }
+
+        return result;
+    }
+
+    bool all() const
+    {
+        return count() == size_;
+    }
+
+    bool any() const
+    {
+        return chunks_quantity_ != 0;
+    }
+
+    bool none() const
+    {
+        return !any();
+    }
+//----------------------------------Bit search-------------------------------------
+    // all of these return size() when there is no such bit
+    size_t find_first() const
+    {
+        return find_forward_(0);
+    }
+
+    size_t find_next(size_t pos) const
+    {
+        return find_forward_(pos + 1);
+    }
+
+    size_t find_last() const
+    {
+        return find_backward_(size_);
+    }
+
+    size_t find_prev(size_t pos) const
+    {
+        return find_backward_(pos);
+    }
+
+    template<typename Visitor>
+    void for_each_set_bit(Visitor visitor) const
+    {
+        for (size_t chunk = 0; chunk < chunks_quantity_; ++chunk)
+        {
+            chunks_[chunk].for_each(visitor, chunks_[chunk].key() << CHUNK_BITS_OFFSET);
+        }
+    }
+//--------------------------------Set operations-----------------------------------
+    CompressedBitVector &operator |=(const CompressedBitVector &other)
+    {
+        return combine_(other, Operation::OR);
+    }
+
+    CompressedBitVector &operator &=(const CompressedBitVector &other)
+    {
+        return combine_(other, Operation::AND);
+    }
+
+    CompressedBitVector &operator ^=(const CompressedBitVector &other)
+    {
+        return combine_(other, Operation::XOR);
+    }
+
+    CompressedBitVector &operator -=(const CompressedBitVector &other)
+    {
+        return combine_(other, Operation::AND_NOT);
+    }
+
+    friend CompressedBitVector operator |(CompressedBitVector left, const CompressedBitVector &right)
+    {
+        return left |= right;
+    }
+
+    friend CompressedBitVector operator &(CompressedBitVector left, const CompressedBitVector &right)
+    {
+        return left &= right;
+    }
+
+    friend CompressedBitVector operator ^(CompressedBitVector left, const CompressedBitVector &right)
+    {
+        return left ^= right;
+    }
+
+    friend CompressedBitVector operator -(CompressedBitVector left, const CompressedBitVector &right)
+    {
+        return left -= right;
+    }
+
+    bool operator ==(const CompressedBitVector &other) const
+    {
+        if ((size_ != other.size_) || (count() != other.count()))
+        {
+            return false;
+        }
+
+        return (CompressedBitVector(*this) ^= other).none();
+    }
+
+    bool operator !=(const CompressedBitVector &other) const
+    {
+        return !operator ==(other);
+    }
+//----------------------------------Conversion-------------------------------------
+    Vector<bool> to_vector() const
+    {
+        if (size_ == 0)
+        {
+            return Vector<bool>();
+        }
+
+        Vector<bool> result(size_, false);
+        size_t result_words = result.words_quantity();
+
+        for (size_t chunk = 0; chunk < chunks_quantity_; ++chunk)
+        {
+            const Container &container = chunks_[chunk];
+            size_t first_word = container.key() * CHUNK_WORDS;
+            size_t base       = container.key() << CHUNK_BITS_OFFSET;
+
+            if (container.type() == ContainerType::BITMAP)
+            {
+                for (size_t word = 0; (word < CHUNK_WORDS) && (first_word + word < result_words); ++word)
+                {
+                    result.set_word(first_word + word, container.words()[word]);
+                }
+            }
+            else
+            {
+                container.for_each([&result](size_t index)
+                                   {
+                                       result.set(index);
+                                   }, base);
+            }
+        }
+
+        return result;
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    size_t lower_chunk_(size_t key) const
+    {
+        size_t left  = 0;
+        size_t right = chunks_quantity_;
+        while (left < right)
+        {
+            size_t middle = left + ((right - left) >> 1);
+            if (chunks_[middle].key() < key)
+            {
+                left = middle + 1;
+            }
+            else
+            {
+                right = middle;
+            }
+        }
+
+        return left;
+    }
+
+    // index of the chunk with this key, chunks quantity if it is absent
+    size_t find_chunk_(size_t key) const
+    {
+        size_t chunk = lower_chunk_(key);
+
+        return ((chunk < chunks_quantity_) && (chunks_[chunk].key() == key)) ? chunk : chunks_quantity_;
+    }
+
+    void reserve_chunks_(size_t quantity)
+    {
+        if (quantity <= chunks_capacity_)
+        {
+            return;
+        }
+
+        size_t new_capacity = std::max<size_t> (quantity, 2 * chunks_capacity_);
+        Container *new_chunks = new Container[new_capacity];
+        for (size_t chunk = 0; chunk < chunks_quantity_; ++chunk)
+        {
+            new_chunks[chunk].swap(chunks_[chunk]);
+        }
+
+        delete [] chunks_;
+        chunks_          = new_chunks;
+        chunks_capacity_ = new_capacity;
+    }
+
+    void append_chunk_(Container &&container)
+    {
+        reserve_chunks_(chunks_quantity_ + 1);
+
+        chunks_[chunks_quantity_++].swap(container);
+    }
+
+    void insert_chunk_(size_t position, Container &&container)
+    {
+        reserve_chunks_(chunks_quantity_ + 1);
+
+        for (size_t chunk = chunks_quantity_; chunk > position; --chunk)
+        {
+            chunks_[chunk].swap(chunks_[chunk - 1]);
+        }
+        chunks_[position].swap(container);
+
+        ++chunks_quantity_;
+    }
+
+    void erase_chunk_(size_t position)
+    {
+        for (size_t chunk = position; chunk + 1 < chunks_quantity_; ++chunk)
+        {
+            chunks_[chunk].swap(chunks_[chunk + 1]);
+        }
+
+        chunks_[--chunks_quantity_] = Container();
+    }
+
+    size_t find_forward_(size_t from) const
+    {
+        if (from >= size_)
+        {
+            return size_;
+        }
+
+        size_t key = from >> CHUNK_BITS_OFFSET;
+        for (size_t chunk = lower_chunk_(key); chunk < chunks_quantity_; ++chunk)
+        {
+            uint32_t low = (chunks_[chunk].key() == key) ? static_cast<uint32_t> (from & CHUNK_LOW_MASK) : 0;
+            uint32_t found = chunks_[chunk].next_set(low);
+            if (found != NO_BIT)
+            {
+                return (chunks_[chunk].key() << CHUNK_BITS_OFFSET) + found;
+            }
+        }
+
+        return size_;
+    }
+
+    // last set bit in [0, to)
+    size_t find_backward_(size_t to) const
+    {
+        if (to > size_)
+        {
+            to = size_;
+        }
+        if (to == 0)
+        {
+            return size_;
+        }
+
+        size_t last = to - 1;
+        size_t key  = last >> CHUNK_BITS_OFFSET;
+        for (size_t chunk = lower_chunk_(key + 1); chunk-- > 0;)
+        {
+            uint32_t low = (chunks_[chunk].key() == key) ? static_cast<uint32_t> (last & CHUNK_LOW_MASK) : CHUNK_LOW_MASK;
+            uint32_t found = chunks_[chunk].prev_set(low);
+            if (found != NO_BIT)
+            {
+                return (chunks_[chunk].key() << CHUNK_BITS_OFFSET) + found;
+            }
+        }
+
+        return size_;
+    }
+
+    // walks both chunk lists in key order, chunks present on one side only are copied or skipped
+    CompressedBitVector &combine_(const CompressedBitVector &other, Operation operation)
+    {
+        CompressedBitVector result(((operation == Operation::OR) || (operation == Operation::XOR)) ?
+                                   std::max(size_, other.size_) : size_);
+        result.reserve_chunks_(chunks_quantity_ + other.chunks_quantity_);
+
+        size_t this_chunk  = 0;
+        size_t other_chunk = 0;
+        while ((this_chunk < chunks_quantity_) || (other_chunk < other.chunks_quantity_))
+        {
+            bool take_this  = (other_chunk == other.chunks_quantity_) ||
+                              ((this_chunk < chunks_quantity_) && (chunks_[this_chunk].key() <= other.chunks_[other_chunk].key()));
+            bool take_other = (this_chunk == chunks_quantity_) ||
+                              ((other_chunk < other.chunks_quantity_) && (other.chunks_[other_chunk].key() <= chunks_[this_chunk].key()));
+
+            if (take_this && take_other)
+            {
+                Container combined = Container::combine(chunks_[this_chunk], other.chunks_[other_chunk], operation);
+                if (combined.cardinality() != 0)
+                {
+                    result.append_chunk_(my_move(combined));
+                }
+            }
+            else if (take_this && (operation != Operation::AND))
+            {
+                result.append_chunk_(Container(chunks_[this_chunk]));
+            }
+            else if (take_other && ((operation == Operation::OR) || (operation == Operation::XOR)))
+            {
+                result.append_chunk_(Container(other.chunks_[other_chunk]));
+            }
+
+            this_chunk  += take_this;
+            other_chunk += take_other;
+        }
+
+        swap(result);
+
+        return *this;
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    size_t size_ = 0;
+
+    Container *chunks_          = nullptr;
+    size_t     chunks_quantity_ = 0;
+    size_t     chunks_capacity_ = 0;
+};
+
+
+#endif
@@ -0,0 +1,444 @@
+#ifndef COMPRESSED_INT_VECTOR_HPP
+#define COMPRESSED_INT_VECTOR_HPP
+
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "bitwords.hpp"
+#include "specialvalues.hpp"
+#include "vector.hpp"
+
+
+const size_t COMPRESSED_BLOCK_SIZE   = 128;
+const size_t COMPRESSED_BLOCK_OFFSET = 7;
+const size_t COMPRESSED_BLOCK_MASK   = 127;
+const size_t MAX_GATHER_INT_WIDTH    = 57;      // 7 bits of misalignment plus the value still fit one unaligned 64-bit load
+
+
+// Append-only uint64_t array compressed in blocks of 128 values: a sealed block keeps its
+// minimum (the frame of reference) and value - minimum bit-packed at the narrowest width
+// that fits, so sorted ids and timestamps shrink to a few bits per value. A block index
+// (reference, word offset, width) keeps operator[] O(1) and the unfilled last block stays
+// plain until it fills up
+class CompressedIntVector
+{
+public:
+//---------------------------------------------------------------------------------
+    CompressedIntVector()
+      : words_(new uint64_t[PADDING_WORDS]{}),
+        words_capacity_(PADDING_WORDS)
+    {}
+
+    CompressedIntVector(const Vector<uint64_t> &values)
+      : CompressedIntVector()
+    {
+        size_t size = values.size();
+        for (size_t index = 0; index < size; ++index)
+        {
+            push_back(values[index]);
+        }
+    }
+
+    CompressedIntVector(const CompressedIntVector &other)
+      : blocks_(new BlockHeader[other.blocks_capacity_ > 0 ? other.blocks_capacity_ : 1]),
+        blocks_quantity_(other.blocks_quantity_),
+        blocks_capacity_(other.blocks_capacity_),
+        words_(new uint64_t[other.words_capacity_]),
+        words_quantity_(other.words_quantity_),
+        words_capacity_(other.words_capacity_),
+        tail_size_(other.tail_size_)
+    {
+        std::copy(other.blocks_, other.blocks_ + blocks_quantity_, blocks_);
+        std::memcpy(words_, other.words_, words_capacity_ * sizeof(uint64_t));
+        std::memcpy(tail_,  other.tail_,  tail_size_ * sizeof(uint64_t));
+    }
+
+    CompressedIntVector(CompressedIntVector &&other)
+      : CompressedIntVector()
+    {
+        swap(other);
+    }
+
+    CompressedIntVector &operator =(const CompressedIntVector &other)
+    {
+        CompressedIntVector copy(other);
+        swap(copy);
+
+        return *this;
+    }
+
+    CompressedIntVector &operator =(CompressedIntVector &&other)
+    {
+        swap(other);
+
+        return *this;
+    }
+
+    ~CompressedIntVector()
+    {
+        delete [] blocks_;
+        delete [] words_;
+
+        blocks_    = const_cast<BlockHeader *> (reinterpret_cast<const BlockHeader *> (DESTR_PTR));
+        words_     = const_cast<uint64_t *> (reinterpret_cast<const uint64_t *> (DESTR_PTR));
+        tail_size_ = POISONED_UINT64_T;
+    }
+
+    void swap(CompressedIntVector &other)
+    {
+        std::swap(blocks_,          other.blocks_);
+        std::swap(blocks_quantity_, other.blocks_quantity_);
+        std::swap(blocks_capacity_, other.blocks_capacity_);
+        std::swap(words_,           other.words_);
+        std::swap(words_quantity_,  other.words_quantity_);
+        std::swap(words_capacity_,  other.words_capacity_);
+        std::swap(tail_,            other.tail_);
+        std::swap(tail_size_,       other.tail_size_);
+    }
+//--------------------------------Size and capacity--------------------------------
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    size_t size() const
+    {
+        return (blocks_quantity_ << COMPRESSED_BLOCK_OFFSET) + tail_size_;
+    }
+
+    size_t sealed_blocks_quantity() const
+    {
+        return blocks_quantity_;
+    }
+
+    size_t memory_usage() const
+    {
+        return sizeof(*this) + blocks_capacity_ * sizeof(BlockHeader) + words_capacity_ * sizeof(uint64_t);
+    }
+    // drops the growth slack of the packed stream and the block index
+    void shrink_to_fit()
+    {
+        size_t words_used = words_quantity_ + PADDING_WORDS;
+        if (words_used < words_capacity_)
+        {
+            uint64_t *new_words = new uint64_t[words_used];
+            std::memcpy(new_words, words_, words_used * sizeof(uint64_t));
+
+            delete [] words_;
+            words_          = new_words;
+            words_capacity_ = words_used;
+        }
+
+        if ((blocks_quantity_ > 0) && (blocks_quantity_ < blocks_capacity_))
+        {
+            BlockHeader *new_blocks = new BlockHeader[blocks_quantity_];
+            std::copy(blocks_, blocks_ + blocks_quantity_, new_blocks);
+
+            delete [] blocks_;
+            blocks_          = new_blocks;
+            blocks_capacity_ = blocks_quantity_;
+        }
+    }
+//-------------------------------Element access------------------------------------
+    uint64_t operator [](size_t index) const
+    {
+        assert(index < size());
+
+        size_t block = index >> COMPRESSED_BLOCK_OFFSET;
+        if (block == blocks_quantity_)
+        {
+            return tail_[index & COMPRESSED_BLOCK_MASK];
+        }
+
+        const BlockHeader &header = blocks_[block];
+
+        return header.reference + extract_(header, index & COMPRESSED_BLOCK_MASK);
+    }
+
+    uint64_t at(size_t index) const
+    {
+        if (index < size())
+        {
+            return operator[](index);
+        }
+
+        std::cerr << "ERROR(CompressedIntVector " << this << "): attempt to obtain value out of bounds" << std::endl;
+
+        return POISONED_UINT64_T;
+    }
+
+    uint64_t front() const
+    {
+        return operator[](0);
+    }
+
+    uint64_t back() const
+    {
+        return operator[](size() - 1);
+    }
+//----------------------------------Modifiers--------------------------------------
+    void push_back(uint64_t value)
+    {
+        tail_[tail_size_++] = value;
+        if (tail_size_ == COMPRESSED_BLOCK_SIZE)
+        {
+            seal_tail_();
+        }
+    }
+
+    void clear()
+    {
+        blocks_quantity_ = 0;
+        words_quantity_  = 0;
+        tail_size_       = 0;
+
+        std::memset(words_, 0, PADDING_WORDS * sizeof(uint64_t));
+    }
+//-----------------------------------Decoding--------------------------------------
+    // the values of block, which may be the unsealed tail, into destination; returns how many
+    size_t decode_block(size_t block, uint64_t *destination) const
+    {
+        assert(block <= blocks_quantity_);
+        assert(destination != nullptr);
+
+        if (block == blocks_quantity_)
+        {
+            std::memcpy(destination, tail_, tail_size_ * sizeof(uint64_t));
+
+            return tail_size_;
+        }
+
+        const BlockHeader &header = blocks_[block];
+        size_t width = header_width_(header);
+
+        if (width == 0)
+        {
+            std::fill(destination, destination + COMPRESSED_BLOCK_SIZE, header.reference);
+
+            return COMPRESSED_BLOCK_SIZE;
+        }
+
+#ifdef __AVX2__
+        if (width <= MAX_GATHER_INT_WIDTH)
+        {
+            decode_block_avx2_(header, destination);
+
+            return COMPRESSED_BLOCK_SIZE;
+        }
+#endif
+
+        for (size_t index = 0; index < COMPRESSED_BLOCK_SIZE; ++index)
+        {
+            destination[index] = header.reference + extract_(header, index);
+        }
+
+        return COMPRESSED_BLOCK_SIZE;
+    }
+
+    // decodes block after block into one reusable buffer, visitor(values, quantity) sees each
+    template<typename Visitor>
+    void for_each_block(Visitor visitor) const
+    {
+        uint64_t buffer[COMPRESSED_BLOCK_SIZE];
+        for (size_t block = 0; block <= blocks_quantity_; ++block)
+        {
+            size_t quantity = decode_block(block, buffer);
+            if (quantity != 0)
+            {
+                visitor(static_cast<const uint64_t *> (buffer), quantity);
+            }
+        }
+    }
+
+    // decodes straight into the destination buffer, which is sized to size() first without
+    // initialising the values every block overwrites anyway
+    void decode(Vector<uint64_t> &destination) const
+    {
+        destination.resize_for_overwrite(size());
+        if (destination.empty())
+        {
+            return;
+        }
+
+        uint64_t *values = destination.data();
+        for (size_t block = 0; block <= blocks_quantity_; ++block)
+        {
+            decode_block(block, values + (block << COMPRESSED_BLOCK_OFFSET));
+        }
+    }
+
+    Vector<uint64_t> to_vector() const
+    {
+        Vector<uint64_t> result;
+        decode(result);
+
+        return result;
+    }
+
+private:
+//-------------------------------------Types---------------------------------------
+    struct BlockHeader
+    {
+        uint64_t reference = 0;
+        uint64_t offset_and_width = 0;                                               // word offset << 8 | width
+    };
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    static size_t header_width_(const BlockHeader &header)
+    {
+        return header.offset_and_width & 0xFF;
+    }
+
+    static size_t header_offset_(const BlockHeader &header)
+    {
+        return header.offset_and_width >> 8;
+    }
+
+    uint64_t extract_(const BlockHeader &header, size_t index_in_block) const
+    {
+        size_t width = header_width_(header);
+        if (width == 0)
+        {
+            return 0;
+        }
+
+        size_t position = index_in_block * width;
+        const uint64_t *block_words = words_ + header_offset_(header) + (position >> BITS_TO_WORDS_OFFSET);
+        size_t shift = position & WORD_BITS_MASK;
+
+        uint64_t value = (block_words[0] >> shift) | ((block_words[1] << 1) << (WORD_BITS_MASK - shift));
+
+        return value & width_mask_(width);
+    }
+
+    static uint64_t width_mask_(size_t width)
+    {
+        return (width >= BITS_IN_WORD) ? ~0ull : (0x1ull << width) - 1;
+    }
+
+    void seal_tail_()
+    {
+        uint64_t minimum = *std::min_element(tail_, tail_ + COMPRESSED_BLOCK_SIZE);
+        uint64_t maximum = *std::max_element(tail_, tail_ + COMPRESSED_BLOCK_SIZE);
+        size_t   width   = static_cast<size_t> (std::bit_width(maximum - minimum));
+
+        size_t block_words = (COMPRESSED_BLOCK_SIZE * width) >> BITS_TO_WORDS_OFFSET;   // 128 values fill whole words
+        reserve_words_(words_quantity_ + block_words + PADDING_WORDS);
+        reserve_blocks_(blocks_quantity_ + 1);
+
+        BlockHeader &header = blocks_[blocks_quantity_++];
+        header.reference        = minimum;
+        header.offset_and_width = (static_cast<uint64_t> (words_quantity_) << 8) | width;
+
+        uint64_t *destination = words_ + words_quantity_;
+        uint64_t buffer = 0;
+        size_t   filled = 0;
+        for (size_t index = 0; (width != 0) && (index < COMPRESSED_BLOCK_SIZE); ++index)
+        {
+            uint64_t value = tail_[index] - minimum;
+
+            buffer |= value << filled;
+            filled += width;
+            if (filled >= BITS_IN_WORD)
+            {
+                *destination++ = buffer;
+
+                filled -= BITS_IN_WORD;
+                buffer  = (filled != 0) ? value >> (width - filled) : 0;
+            }
+        }
+
+        words_quantity_ += block_words;
+        std::memset(words_ + words_quantity_, 0, PADDING_WORDS * sizeof(uint64_t));
+
+        tail_size_ = 0;
+    }
+
+    void reserve_words_(size_t required)
+    {
+        if (required <= words_capacity_)
+        {
+            return;
+        }
+
+        size_t new_capacity = std::max(required, words_capacity_ * DEFAULT_RESIZE_MULTIPLIER);
+        uint64_t *new_words = new uint64_t[new_capacity];
+        std::memcpy(new_words, words_, words_capacity_ * sizeof(uint64_t));
+
+        delete [] words_;
+        words_          = new_words;
+        words_capacity_ = new_capacity;
+    }
+
+    void reserve_blocks_(size_t required)
+    {
+        if (required <= blocks_capacity_)
+        {
+            return;
+        }
+
+        size_t new_capacity = std::max(required, blocks_capacity_ * DEFAULT_RESIZE_MULTIPLIER);
+        BlockHeader *new_blocks = new BlockHeader[new_capacity];
+        std::copy(blocks_, blocks_ + blocks_quantity_, new_blocks);
+
+        delete [] blocks_;
+        blocks_          = new_blocks;
+        blocks_capacity_ = new_capacity;
+    }
+
+#ifdef __AVX2__
+    // four values per step: one unaligned 64-bit gather from the byte holding each value,
+    // then a per-lane shift, mask and add of the reference
+    void decode_block_avx2_(const BlockHeader &header, uint64_t *destination) const
+    {
+        size_t width = header_width_(header);
+
+        const long long *bytes = reinterpret_cast<const long long *> (words_ + header_offset_(header));
+        const __m256i step      = _mm256_set1_epi64x(static_cast<long long> (4 * width));
+        const __m256i low_bits  = _mm256_set1_epi64x(7);
+        const __m256i mask      = _mm256_set1_epi64x(static_cast<long long> (width_mask_(width)));
+        const __m256i reference = _mm256_set1_epi64x(static_cast<long long> (header.reference));
+
+        __m256i positions = _mm256_setr_epi64x(0, static_cast<long long> (width),
+                                               static_cast<long long> (2 * width), static_cast<long long> (3 * width));
+        for (size_t index = 0; index < COMPRESSED_BLOCK_SIZE; index += 4)
+        {
+            __m256i loaded = _mm256_i64gather_epi64(bytes, _mm256_srli_epi64(positions, 3), 1);
+            __m256i values = _mm256_and_si256(_mm256_srlv_epi64(loaded, _mm256_and_si256(positions, low_bits)), mask);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i *> (destination + index), _mm256_add_epi64(values, reference));
+
+            positions = _mm256_add_epi64(positions, step);
+        }
+    }
+#endif
+
+private:
+//-----------------------------------Variables-------------------------------------
+    static constexpr size_t PADDING_WORDS             = 2;     // straddling reads and unaligned gathers past the last block
+    static constexpr size_t DEFAULT_RESIZE_MULTIPLIER = 2;
+
+    BlockHeader *blocks_ = nullptr;
+    size_t blocks_quantity_ = 0;
+    size_t blocks_capacity_ = 0;
+
+    uint64_t *words_ = nullptr;
+    size_t words_quantity_ = 0;
+    size_t words_capacity_ = 0;
+
+    uint64_t tail_[COMPRESSED_BLOCK_SIZE] = {};
+    size_t tail_size_ = 0;
+};
+
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef DYNAMIC_ALLOC_HPP
+#define DYNAMIC_ALLOC_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+
+// Where the containers take their storage from: a Vector keeps a pointer to one of these
+// and returns every buffer to the allocator that gave it
+class Allocator
+{
+public:
+    virtual ~Allocator() = default;
+
+    virtual char *allocate(size_t bytes) = 0;
+    virtual void deallocate(char *data, size_t bytes) = 0;
+
+    // bytes a request of this size really takes, all of them usable by the caller
+    virtual size_t usable_size(size_t bytes) const
+    {
+        return bytes;
+    }
+};
+
+
+// Plain heap memory through new [] and delete [], the default of every container
+class DynamicAlloc : public Allocator
+{
+public:
+    char *allocate(size_t bytes) override
+    {
+        return new char[bytes > 0 ? bytes : 1];
+    }
+
+    void deallocate(char *data, size_t /* bytes */) override
+    {
+        delete [] data;
+    }
+};
+
+
+inline DynamicAlloc *default_allocator()
+{
+    static DynamicAlloc allocator;
+
+    return &allocator;
+}
+
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef GROWTH_POLICY_HPP
+#define GROWTH_POLICY_HPP
+
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include "dynamicalloc.hpp"
+
+
+// How a container picks its next capacity, in elements: next_capacity() gets the current
+// capacity, the number of elements that must fit, the allocator the buffer will come from and
+// the size of an element, and returns at least required. The result is used as it is, so a
+// policy only has to care about the trade-off it is named after
+
+// powers of two: the fewest reallocations, up to half of the buffer left unused
+struct DoublingGrowth
+{
+    static size_t next_capacity(size_t /* capacity */, size_t required, const Allocator & /* alloc */, size_t /* elem_bytes */)
+    {
+        return std::bit_ceil(required);
+    }
+};
+
+// a factor below the golden ratio: after a few steps the blocks freed by earlier growths
+// add up to the next request, so the allocator can serve it from memory it already has
+struct OneAndHalfGrowth
+{
+    static size_t next_capacity(size_t capacity, size_t required, const Allocator & /* alloc */, size_t /* elem_bytes */)
+    {
+        return std::max(required, capacity + (capacity >> 1));
+    }
+};
+
+// grows by half and then takes the whole block the allocator hands out for that request,
+// so the rounding a size class does anyway becomes capacity instead of waste
+struct SizeClassGrowth
+{
+    static size_t next_capacity(size_t capacity, size_t required, const Allocator &alloc, size_t elem_bytes)
+    {
+        size_t wanted = OneAndHalfGrowth::next_capacity(capacity, required, alloc, elem_bytes);
+
+        return std::max(wanted, alloc.usable_size(wanted * elem_bytes) / elem_bytes);
+    }
+};
+
+
+// Opt-in shrinking on top of any growth policy: a container whose policy has shrink_capacity()
+// asks it after every removal. Once fewer than a quarter of the elements are in use the buffer
+// is cut to twice the size, so a vector that spiked once gives the memory back, while the
+// gap between the two thresholds keeps a size that moves back and forth from reallocating
+template<typename Growth = DoublingGrowth>
+struct ShrinkingGrowth : Growth
+{
+    static size_t shrink_capacity(size_t capacity, size_t size)
+    {
+        return (size < (capacity >> 2)) ? (size << 1) : capacity;
+    }
+};
+
+
+#endif
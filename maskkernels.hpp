@@ -0,0 +1,450 @@
+#ifndef MASK_KERNELS_HPP
+#define MASK_KERNELS_HPP
+
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#include "bitvector.hpp"
+#include "bitwords.hpp"
+#include "vector.hpp"
+
+
+// Selection as two branch-free passes: compare_to_mask evaluates a predicate into a packed
+// Vector<bool>, then compress gathers the selected elements (or expand scatters them back).
+// Masks are read in reverse_bit_word(get_word(w)) form, where bit j is element 64 * w + j
+
+enum class CompareOp
+{
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL
+};
+
+
+template<CompareOp Op, typename Type>
+inline bool compare_values(const Type &lhs, const Type &rhs)
+{
+    if constexpr (Op == CompareOp::EQUAL)         return lhs == rhs;
+    if constexpr (Op == CompareOp::NOT_EQUAL)     return lhs != rhs;
+    if constexpr (Op == CompareOp::LESS)          return lhs < rhs;
+    if constexpr (Op == CompareOp::LESS_EQUAL)    return lhs <= rhs;
+    if constexpr (Op == CompareOp::GREATER)       return lhs > rhs;
+    if constexpr (Op == CompareOp::GREATER_EQUAL) return lhs >= rhs;
+}
+
+
+// set bit positions of every byte value, ascending, padded with zeroes
+struct MaskLookupTable
+{
+    uint8_t positions[256][8];
+    uint8_t counts[256];
+};
+
+inline constexpr MaskLookupTable make_mask_lookup_table()
+{
+    MaskLookupTable table = {};
+    for (size_t byte = 0; byte < 256; ++byte)
+    {
+        uint8_t count = 0;
+        for (uint8_t bit = 0; bit < 8; ++bit)
+        {
+            if ((byte >> bit) & 1)
+            {
+                table.positions[byte][count++] = bit;
+            }
+        }
+
+        table.counts[byte] = count;
+    }
+
+    return table;
+}
+
+inline constexpr MaskLookupTable MASK_LOOKUP_TABLE = make_mask_lookup_table();
+
+
+#ifdef __AVX2__
+template<CompareOp Op>
+inline uint32_t compare_avx2(__m256i lhs, __m256i rhs)
+{
+    __m256i result;
+    if constexpr ((Op == CompareOp::EQUAL) || (Op == CompareOp::NOT_EQUAL))
+    {
+        result = _mm256_cmpeq_epi32(lhs, rhs);
+    }
+    if constexpr ((Op == CompareOp::GREATER) || (Op == CompareOp::LESS_EQUAL))
+    {
+        result = _mm256_cmpgt_epi32(lhs, rhs);
+    }
+    if constexpr ((Op == CompareOp::LESS) || (Op == CompareOp::GREATER_EQUAL))
+    {
+        result = _mm256_cmpgt_epi32(rhs, lhs);
+    }
+
+    uint32_t bits = static_cast<uint32_t> (_mm256_movemask_ps(_mm256_castsi256_ps(result)));
+    if constexpr ((Op == CompareOp::NOT_EQUAL) || (Op == CompareOp::LESS_EQUAL) || (Op == CompareOp::GREATER_EQUAL))
+    {
+        bits ^= 0xFF;
+    }
+
+    return bits;
+}
+
+template<CompareOp Op>
+inline uint32_t compare_avx2(__m256 lhs, __m256 rhs)
+{
+    __m256 result;
+    if constexpr (Op == CompareOp::EQUAL)         result = _mm256_cmp_ps(lhs, rhs, _CMP_EQ_OQ);
+    if constexpr (Op == CompareOp::NOT_EQUAL)     result = _mm256_cmp_ps(lhs, rhs, _CMP_NEQ_UQ);
+    if constexpr (Op == CompareOp::LESS)          result = _mm256_cmp_ps(lhs, rhs, _CMP_LT_OQ);
+    if constexpr (Op == CompareOp::LESS_EQUAL)    result = _mm256_cmp_ps(lhs, rhs, _CMP_LE_OQ);
+    if constexpr (Op == CompareOp::GREATER)       result = _mm256_cmp_ps(lhs, rhs, _CMP_GT_OQ);
+    if constexpr (Op == CompareOp::GREATER_EQUAL) result = _mm256_cmp_ps(lhs, rhs, _CMP_GE_OQ);
+
+    return static_cast<uint32_t> (_mm256_movemask_ps(result));
+}
+
+template<typename Type>
+inline auto load_avx2(const Type *values)
+{
+    if constexpr (std::is_same_v<Type, float>)
+    {
+        return _mm256_loadu_ps(values);
+    }
+    else
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *> (values));
+    }
+}
+
+template<typename Type>
+inline auto broadcast_avx2(const Type &value)
+{
+    if constexpr (std::is_same_v<Type, float>)
+    {
+        return _mm256_set1_ps(value);
+    }
+    else
+    {
+        return _mm256_set1_epi32(value);
+    }
+}
+#endif
+
+
+// lhs_stride == 0 or rhs_stride == 0 broadcasts a scalar
+template<CompareOp Op, typename Type>
+inline Vector<bool> compare_to_mask_kernel(const Type *lhs, size_t lhs_stride, const Type *rhs, size_t rhs_stride, size_t size)
+{
+    if (size == 0)
+    {
+        return Vector<bool>();
+    }
+
+    Vector<bool> mask(size, false);
+
+    size_t words = mask.words_quantity();
+    for (size_t word_index = 0; word_index < words; ++word_index)
+    {
+        size_t base     = word_index << BITS_TO_WORDS_OFFSET;
+        size_t in_word  = std::min(BITS_IN_WORD, size - base);
+        uint64_t word   = 0;                                                          // bit j is element base + j
+
+#ifdef __AVX2__
+        if constexpr (std::is_same_v<Type, int32_t> || std::is_same_v<Type, float>)
+        {
+            if (in_word == BITS_IN_WORD)
+            {
+                for (size_t lane = 0; lane < BITS_IN_WORD; lane += 8)
+                {
+                    auto lhs_lanes = (lhs_stride != 0) ? load_avx2(lhs + base + lane) : broadcast_avx2(*lhs);
+                    auto rhs_lanes = (rhs_stride != 0) ? load_avx2(rhs + base + lane) : broadcast_avx2(*rhs);
+
+                    word |= static_cast<uint64_t> (compare_avx2<Op>(lhs_lanes, rhs_lanes)) << lane;
+                }
+
+                mask.set_word(word_index, reverse_bit_word(word));
+
+                continue;
+            }
+        }
+#endif
+
+        for (size_t index = 0; index < in_word; ++index)
+        {
+            bool result = compare_values<Op>(lhs[(base + index) * lhs_stride], rhs[(base + index) * rhs_stride]);
+            word |= static_cast<uint64_t> (result) << index;
+        }
+
+        mask.set_word(word_index, reverse_bit_word(word));
+    }
+
+    return mask;
+}
+
+template<typename Type>
+inline Vector<bool> compare_to_mask_dispatch(CompareOp op, const Type *lhs, size_t lhs_stride, const Type *rhs, size_t rhs_stride, size_t size)
+{
+    switch (op)
+    {
+        case CompareOp::EQUAL:         return compare_to_mask_kernel<CompareOp::EQUAL>        (lhs, lhs_stride, rhs, rhs_stride, size);
+        case CompareOp::NOT_EQUAL:     return compare_to_mask_kernel<CompareOp::NOT_EQUAL>    (lhs, lhs_stride, rhs, rhs_stride, size);
+        case CompareOp::LESS:          return compare_to_mask_kernel<CompareOp::LESS>         (lhs, lhs_stride, rhs, rhs_stride, size);
+        case CompareOp::LESS_EQUAL:    return compare_to_mask_kernel<CompareOp::LESS_EQUAL>   (lhs, lhs_stride, rhs, rhs_stride, size);
+        case CompareOp::GREATER:       return compare_to_mask_kernel<CompareOp::GREATER>      (lhs, lhs_stride, rhs, rhs_stride, size);
+        case CompareOp::GREATER_EQUAL: return compare_to_mask_kernel<CompareOp::GREATER_EQUAL>(lhs, lhs_stride, rhs, rhs_stride, size);
+    }
+
+    return Vector<bool>();
+}
+
+// mask[i] = values[i] op scalar
+template<typename Type>
+inline Vector<bool> compare_to_mask(const Vector<Type> &values, CompareOp op, const Type &scalar)
+{
+    if (values.empty())
+    {
+        return Vector<bool>();
+    }
+
+    return compare_to_mask_dispatch(op, values.data(), 1, &scalar, 0, values.size());
+}
+
+// mask[i] = lhs[i] op rhs[i]
+template<typename Type>
+inline Vector<bool> compare_to_mask(const Vector<Type> &lhs, CompareOp op, const Vector<Type> &rhs)
+{
+    assert(lhs.size() == rhs.size());
+
+    if (lhs.empty())
+    {
+        return Vector<bool>();
+    }
+
+    return compare_to_mask_dispatch(op, lhs.data(), 1, rhs.data(), 1, lhs.size());
+}
+
+
+// selected elements of one 64-element block (bit j of bits is block[j]) written at dest,
+// returns how many; room_left is how many slots dest still has
+template<typename Type>
+inline size_t compress_block(const Type *block, uint64_t bits, Type *dest, size_t room_left)
+{
+#ifdef __AVX512F__
+    if constexpr (std::is_trivially_copyable_v<Type> && ((sizeof(Type) == 4) || (sizeof(Type) == 8)))
+    {
+        constexpr size_t LANES = 64 / sizeof(Type);
+
+        size_t written = 0;
+        for (size_t lane = 0; lane < BITS_IN_WORD; lane += LANES)
+        {
+            uint64_t lanes_bits = (bits >> lane) & ((0x1ull << LANES) - 1);
+            if (lanes_bits == 0)
+            {
+                continue;
+            }
+
+            if constexpr (sizeof(Type) == 4)
+            {
+                __mmask16 lanes_mask = static_cast<__mmask16> (lanes_bits);
+                __m512i lanes_values = _mm512_maskz_loadu_epi32(lanes_mask, block + lane);
+                _mm512_mask_compressstoreu_epi32(dest + written, lanes_mask, lanes_values);
+            }
+            else
+            {
+                __mmask8 lanes_mask  = static_cast<__mmask8> (lanes_bits);
+                __m512i lanes_values = _mm512_maskz_loadu_epi64(lanes_mask, block + lane);
+                _mm512_mask_compressstoreu_epi64(dest + written, lanes_mask, lanes_values);
+            }
+
+            written += static_cast<size_t> (std::popcount(lanes_bits));
+        }
+
+        return written;
+    }
+#endif
+
+    if constexpr (std::is_trivially_copyable_v<Type>)
+    {
+        size_t written = 0;
+        for (size_t byte_offset = 0; byte_offset < BITS_IN_WORD; byte_offset += 8)
+        {
+            uint8_t byte = static_cast<uint8_t> (bits >> byte_offset);
+            if (byte == 0)
+            {
+                continue;
+            }
+
+            const uint8_t *positions = MASK_LOOKUP_TABLE.positions[byte];
+            const Type    *source    = block + byte_offset;
+            if (written + 8 <= room_left)                                                 // fixed trip count, no branch per element
+            {
+                for (size_t slot = 0; slot < 8; ++slot)
+                {
+                    dest[written + slot] = source[positions[slot]];
+                }
+            }
+            else
+            {
+                for (size_t slot = 0; slot < MASK_LOOKUP_TABLE.counts[byte]; ++slot)
+                {
+                    dest[written + slot] = source[positions[slot]];
+                }
+            }
+
+            written += MASK_LOOKUP_TABLE.counts[byte];
+        }
+
+        return written;
+    }
+    else
+    {
+        size_t written = 0;
+        for (; bits != 0; bits &= bits - 1)
+        {
+            dest[written++] = block[std::countr_zero(bits)];
+        }
+
+        return written;
+    }
+}
+
+// scatters the next popcount(bits) source elements to the set positions of the block
+template<typename Type>
+inline size_t expand_block(const Type *source, uint64_t bits, Type *block)
+{
+#ifdef __AVX512F__
+    if constexpr (std::is_trivially_copyable_v<Type> && ((sizeof(Type) == 4) || (sizeof(Type) == 8)))
+    {
+        constexpr size_t LANES = 64 / sizeof(Type);
+
+        size_t read = 0;
+        for (size_t lane = 0; lane < BITS_IN_WORD; lane += LANES)
+        {
+            uint64_t lanes_bits = (bits >> lane) & ((0x1ull << LANES) - 1);
+            if (lanes_bits == 0)
+            {
+                continue;
+            }
+
+            if constexpr (sizeof(Type) == 4)
+            {
+                __mmask16 lanes_mask = static_cast<__mmask16> (lanes_bits);
+                _mm512_mask_storeu_epi32(block + lane, lanes_mask, _mm512_maskz_expandloadu_epi32(lanes_mask, source + read));
+            }
+            else
+            {
+                __mmask8 lanes_mask = static_cast<__mmask8> (lanes_bits);
+                _mm512_mask_storeu_epi64(block + lane, lanes_mask, _mm512_maskz_expandloadu_epi64(lanes_mask, source + read));
+            }
+
+            read += static_cast<size_t> (std::popcount(lanes_bits));
+        }
+
+        return read;
+    }
+#endif
+
+    size_t read = 0;
+    for (size_t byte_offset = 0; byte_offset < BITS_IN_WORD; byte_offset += 8)
+    {
+        uint8_t byte = static_cast<uint8_t> (bits >> byte_offset);
+
+        const uint8_t *positions = MASK_LOOKUP_TABLE.positions[byte];
+        for (size_t slot = 0; slot < MASK_LOOKUP_TABLE.counts[byte]; ++slot)
+        {
+            block[byte_offset + positions[slot]] = source[read + slot];
+        }
+
+        read += MASK_LOOKUP_TABLE.counts[byte];
+    }
+
+    return read;
+}
+
+// values[i] for every set mask[i], in order; the result is sized by a popcount first
+template<typename Type>
+inline Vector<Type> compress(const Vector<Type> &values, const Vector<bool> &mask)
+{
+    assert(values.size() == mask.size());
+
+    size_t selected = mask.count();
+    Vector<Type> result(selected);
+    if (selected == 0)
+    {
+        return result;
+    }
+
+    const Type *source  = values.data();
+    Type       *dest    = result.data();
+    size_t      written = 0;
+
+    size_t words = mask.words_quantity();
+    for (size_t word_index = 0; word_index < words; ++word_index)
+    {
+        uint64_t bits = reverse_bit_word(mask.get_word(word_index));
+        if (bits == 0)
+        {
+            continue;
+        }
+
+        const Type *block = source + (word_index << BITS_TO_WORDS_OFFSET);
+        if (bits == ~0ull)
+        {
+            std::copy(block, block + BITS_IN_WORD, dest + written);
+            written += BITS_IN_WORD;
+
+            continue;
+        }
+
+        written += compress_block(block, bits, dest + written, selected - written);
+    }
+
+    return result;
+}
+
+// inverse of compress: result has mask.size() elements, set positions take values in order
+// and the others are fill
+template<typename Type>
+inline Vector<Type> expand(const Vector<Type> &values, const Vector<bool> &mask, const Type &fill = Type())
+{
+    assert(values.size() >= mask.count());
+
+    Vector<Type> result(mask.size(), fill);
+    if (values.empty())
+    {
+        return result;
+    }
+
+    const Type *source = values.data();
+    Type       *dest   = result.data();
+    size_t      read   = 0;
+
+    size_t words = mask.words_quantity();
+    for (size_t word_index = 0; word_index < words; ++word_index)
+    {
+        uint64_t bits = reverse_bit_word(mask.get_word(word_index));
+        if (bits == 0)
+        {
+            continue;
+        }
+
+        read += expand_block(source + read, bits, dest + (word_index << BITS_TO_WORDS_OFFSET));
+    }
+
+    return result;
+}
+
+
+#endif
@@ -2,46 +2,131 @@
 #define MEMORY_UTILITIES_HPP
 
 
+#include <bit>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <new>
+#include <type_traits>
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "myforward.hpp"
+#include "mymove.hpp"
+
+
+const size_t NON_TEMPORAL_COPY_THRESHOLD = (1ul << 21);        // larger copies would evict the whole cache anyway
+
 
+// Row primitives over raw storage: every *_row function works on quantity consecutive
+// elements and picks memcpy/memmove/memset or no work at all when the type traits allow,
+// falling back to element-wise construction, assignment and destruction otherwise.
+// A construction that throws destroys what the row had constructed before rethrowing
 
+// static_cast where the types convert, otherwise the same bits under the other type:
+// pointers through reinterpret_cast, equally sized trivially copyable values through bit_cast
 template<typename CastFrom, typename CastTo>
 CastTo cast(CastFrom to_cast)
 {
-    // do convenient cast
+    if constexpr (std::is_convertible_v<CastFrom, CastTo>)
+    {
+        return static_cast<CastTo> (to_cast);
+    }
+    else if constexpr (std::is_pointer_v<CastFrom> && std::is_pointer_v<CastTo>)
+    {
+        return reinterpret_cast<CastTo> (to_cast);
+    }
+    else
+    {
+        static_assert((sizeof(CastFrom) == sizeof(CastTo)) && std::is_trivially_copyable_v<CastFrom> && std::is_trivially_copyable_v<CastTo>,
+                      "no conversion and no bit-for-bit reinterpretation between these types");
+
+        return std::bit_cast<CastTo> (to_cast);
+    }
 }
 
-template<typename Type>
-void init_elem_default(Type *where)
+//-------------------------------Byte blocks---------------------------------------
+#if defined(__AVX__) || defined(__SSE2__)
+// streaming stores bypass the cache, the loads stay unaligned and only dest is aligned
+inline void stream_copy_block(void *dest, const void *src, size_t bytes)
 {
-    assert(where != nullptr);
+#ifdef __AVX__
+    using Lane = __m256i;
+#else
+    using Lane = __m128i;
+#endif
+    const size_t LANE_BYTES = sizeof(Lane);
 
-    new (where) Type();
+    char       *to   = static_cast<char *> (dest);
+    const char *from = static_cast<const char *> (src);
+
+    size_t head = (LANE_BYTES - (reinterpret_cast<uintptr_t> (to) & (LANE_BYTES - 1))) & (LANE_BYTES - 1);
+    head = head < bytes ? head : bytes;
+    std::memcpy(to, from, head);
+    to    += head;
+    from  += head;
+    bytes -= head;
+
+    size_t body = bytes & ~(4 * LANE_BYTES - 1);
+    for (size_t offset = 0; offset < body; offset += 4 * LANE_BYTES)
+    {
+#ifdef __AVX__
+        __m256i lane0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *> (from + offset));
+        __m256i lane1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *> (from + offset + LANE_BYTES));
+        __m256i lane2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *> (from + offset + 2 * LANE_BYTES));
+        __m256i lane3 = _mm256_loadu_si256(reinterpret_cast<const __m256i *> (from + offset + 3 * LANE_BYTES));
+        _mm256_stream_si256(reinterpret_cast<__m256i *> (to + offset),                  lane0);
+        _mm256_stream_si256(reinterpret_cast<__m256i *> (to + offset + LANE_BYTES),     lane1);
+        _mm256_stream_si256(reinterpret_cast<__m256i *> (to + offset + 2 * LANE_BYTES), lane2);
+        _mm256_stream_si256(reinterpret_cast<__m256i *> (to + offset + 3 * LANE_BYTES), lane3);
+#else
+        __m128i lane0 = _mm_loadu_si128(reinterpret_cast<const __m128i *> (from + offset));
+        __m128i lane1 = _mm_loadu_si128(reinterpret_cast<const __m128i *> (from + offset + LANE_BYTES));
+        __m128i lane2 = _mm_loadu_si128(reinterpret_cast<const __m128i *> (from + offset + 2 * LANE_BYTES));
+        __m128i lane3 = _mm_loadu_si128(reinterpret_cast<const __m128i *> (from + offset + 3 * LANE_BYTES));
+        _mm_stream_si128(reinterpret_cast<__m128i *> (to + offset),                  lane0);
+        _mm_stream_si128(reinterpret_cast<__m128i *> (to + offset + LANE_BYTES),     lane1);
+        _mm_stream_si128(reinterpret_cast<__m128i *> (to + offset + 2 * LANE_BYTES), lane2);
+        _mm_stream_si128(reinterpret_cast<__m128i *> (to + offset + 3 * LANE_BYTES), lane3);
+#endif
+    }
+    _mm_sfence();                                                  // streaming stores are weakly ordered
+
+    std::memcpy(to + body, from + body, bytes - body);
 }
+#endif
 
-template<typename Type>
-size_t init_elem_row_default(Type *where, size_t from, size_t to)       // gonna remove this: default parameter to value // or current distinction is correct?
+// non-overlapping bytes, streamed past the cache from NON_TEMPORAL_COPY_THRESHOLD on
+inline void copy_block(void *dest, const void *src, size_t bytes)
 {
-    assert(where != nullptr);
+    assert(((dest != nullptr) && (src != nullptr)) || (bytes == 0));
+
+    if (bytes == 0)
+    {
+        return;
+    }
 
-    while (from < to)
+#if defined(__AVX__) || defined(__SSE2__)
+    if (bytes >= NON_TEMPORAL_COPY_THRESHOLD)
     {
-        init_elem_default(where + from);
+        stream_copy_block(dest, src, bytes);
 
-        ++from;
+        return;
     }
+#endif
 
-    return to;
+    std::memcpy(dest, src, bytes);
 }
 
+//-------------------------------Construction--------------------------------------
 template<typename Type>
-size_t init_elem_row_default(Type *where, size_t quantity)
+void init_elem_default(Type *where)
 {
     assert(where != nullptr);
 
-    return init_elem_row_default(where, 0, quantity);
+    new (where) Type();
 }
 
 template<typename Type, typename... ArgsT>
@@ -53,76 +138,279 @@ void init_elem(Type *where, ArgsT &&... args)
 }
 
 template<typename Type>
-size_t init_elem_row(Type *where, size_t quantity, const Type &value)
+void destroy_elem(Type *where)
 {
     assert(where != nullptr);
 
-    for (size_t cur_elem_index = 0; cur_elem_index < quantity; ++cur_elem_index)
+    where->~Type();
+}
+
+template<typename Type>
+void destroy_elem_row(Type *where, size_t quantity)
+{
+    assert((where != nullptr) || (quantity == 0));
+
+    if constexpr (!std::is_trivially_destructible_v<Type>)
+    {
+        for (size_t index = 0; index < quantity; ++index)
+        {
+            destroy_elem(where + index);
+        }
+    }
+}
+
+template<typename Type>
+void destroy_elem_row(Type *where, size_t from, size_t to)
+{
+    assert(from <= to);
+
+    destroy_elem_row(where + from, to - from);
+}
+
+// value-initialised elements, zero bytes for trivial types
+template<typename Type>
+size_t init_elem_row_default(Type *where, size_t quantity)
+{
+    assert((where != nullptr) || (quantity == 0));
+
+    if constexpr (std::is_trivially_default_constructible_v<Type> && std::is_trivially_copyable_v<Type>)
+    {
+        if (quantity > 0)
+        {
+            std::memset(static_cast<void *> (where), 0, quantity * sizeof(Type));
+        }
+    }
+    else
     {
-        init_elem(where + cur_elem_index, value);
+        size_t index = 0;
+        try
+        {
+            for (; index < quantity; ++index)
+            {
+                init_elem_default(where + index);
+            }
+        }
+        catch (...)
+        {
+            destroy_elem_row(where, index);
+            throw;
+        }
     }
 
     return quantity;
 }
 
 template<typename Type>
-void destroy_elem(Type *where)
+size_t init_elem_row_default(Type *where, size_t from, size_t to)
 {
-    assert(where != nullptr);
+    assert(from <= to);
 
-    where->~Type();
+    init_elem_row_default(where + from, to - from);
+
+    return to;
 }
 
+// quantity copies of value
 template<typename Type>
-void destroy_elem_row(Type *where, size_t from, size_t to)
+size_t uninitialized_fill_row(Type *where, size_t quantity, const Type &value)
 {
-    assert(where != nullptr);
+    assert((where != nullptr) || (quantity == 0));
 
-    while (from < to)
+    if constexpr (std::is_trivially_copyable_v<Type> && (sizeof(Type) == 1))
+    {
+        if (quantity > 0)
+        {
+            std::memset(static_cast<void *> (where), std::bit_cast<uint8_t> (value), quantity);
+        }
+    }
+    else if constexpr (std::is_trivially_copyable_v<Type>)
+    {
+        Type copy = value;                                                  // value may live inside the row
+        for (size_t index = 0; index < quantity; ++index)
+        {
+            where[index] = copy;
+        }
+    }
+    else
     {
-        destroy_elem(where + from);
+        size_t index = 0;
+        try
+        {
+            for (; index < quantity; ++index)
+            {
+                init_elem(where + index, value);
+            }
+        }
+        catch (...)
+        {
+            destroy_elem_row(where, index);
+            throw;
+        }
+    }
+
+    return quantity;
+}
+
+template<typename Type>
+size_t init_elem_row(Type *where, size_t quantity, const Type &value)
+{
+    return uninitialized_fill_row(where, quantity, value);
+}
 
-        ++from;
+// copy-constructs src into the raw storage at dest, the rows must not overlap
+template<typename Type>
+void uninitialized_copy_row(Type *dest, const Type *src, size_t quantity)
+{
+    assert(((dest != nullptr) && (src != nullptr)) || (quantity == 0));
+
+    if constexpr (std::is_trivially_copyable_v<Type>)
+    {
+        copy_block(dest, src, quantity * sizeof(Type));
+    }
+    else
+    {
+        size_t index = 0;
+        try
+        {
+            for (; index < quantity; ++index)
+            {
+                init_elem(dest + index, src[index]);
+            }
+        }
+        catch (...)
+        {
+            destroy_elem_row(dest, index);
+            throw;
+        }
     }
 }
 
+// move-constructs src into the raw storage at dest, src keeps its moved-from elements
 template<typename Type>
-void destroy_elem_row(Type *where, size_t quantity)
+void uninitialized_move_row(Type *dest, Type *src, size_t quantity)
 {
-    assert(where != nullptr);
+    assert(((dest != nullptr) && (src != nullptr)) || (quantity == 0));
+
+    if constexpr (std::is_trivially_copyable_v<Type>)
+    {
+        copy_block(dest, src, quantity * sizeof(Type));
+    }
+    else
+    {
+        size_t index = 0;
+        try
+        {
+            for (; index < quantity; ++index)
+            {
+                init_elem(dest + index, my_move(src[index]));
+            }
+        }
+        catch (...)
+        {
+            destroy_elem_row(dest, index);
+            throw;
+        }
+    }
+}
+
+// the move_if_noexcept rule for a whole row: moving is only chosen when it cannot throw or
+// when there is no copy to fall back to, so a failure midway leaves src as it was
+template<typename Type>
+constexpr bool relocates_by_move()
+{
+    return std::is_nothrow_move_constructible_v<Type> || !std::is_copy_constructible_v<Type>;
+}
+
+template<typename Type>
+void uninitialized_move_if_noexcept_row(Type *dest, Type *src, size_t quantity)
+{
+    if constexpr (relocates_by_move<Type>())
+    {
+        uninitialized_move_row(dest, src, quantity);
+    }
+    else
+    {
+        uninitialized_copy_row(dest, static_cast<const Type *> (src), quantity);
+    }
+}
 
-    destroy_elem_row(where, 0, quantity);
+// the elements of src end up at dest and src becomes raw storage; src is only destroyed
+// once every element has been moved or copied, so a throwing copy leaves it untouched
+template<typename Type>
+void relocate_row(Type *dest, Type *src, size_t quantity)
+{
+    if constexpr (std::is_trivially_copyable_v<Type>)
+    {
+        copy_block(dest, src, quantity * sizeof(Type));
+    }
+    else
+    {
+        uninitialized_move_if_noexcept_row(dest, src, quantity);
+        destroy_elem_row(src, quantity);
+    }
 }
 
+//-------------------------------Assignment----------------------------------------
+// copy-assigns src over the constructed elements at dest, the rows may overlap
 template<typename Type>
 void copy_data(Type *dest, const Type *src, size_t quantity)
 {
-    assert(dest != nullptr);
-    assert(src  != nullptr);
+    assert(((dest != nullptr) && (src != nullptr)) || (quantity == 0));
 
-    if (dest == src)
+    if ((dest == src) || (quantity == 0))
     {
         return;
     }
 
-    Type *dest_copy      = dest;
-    const Type *src_copy = src_copy;
+    if constexpr (std::is_trivially_copyable_v<Type>)
+    {
+        std::memmove(static_cast<void *> (dest), src, quantity * sizeof(Type));
+    }
+    else if (dest < src)
+    {
+        for (size_t index = 0; index < quantity; ++index)
+        {
+            dest[index] = src[index];
+        }
+    }
+    else
+    {
+        for (size_t index = quantity; index > 0; --index)
+        {
+            dest[index - 1] = src[index - 1];
+        }
+    }
+}
+
+// move-assigns src over the constructed elements at dest, the rows may overlap
+template<typename Type>
+void move_data(Type *dest, Type *src, size_t quantity)
+{
+    assert(((dest != nullptr) && (src != nullptr)) || (quantity == 0));
 
-    bool from_left_to_right = false;
-    if (dest > src)
+    if ((dest == src) || (quantity == 0))
     {
-        from_left_to_right = true;
-        dest_copy += quantity - 1;
-        src_copy  += quantity - 1;
+        return;
     }
 
-    for (size_t counter = 0; counter < quantity; ++counter)
+    if constexpr (std::is_trivially_copyable_v<Type>)
+    {
+        std::memmove(static_cast<void *> (dest), src, quantity * sizeof(Type));
+    }
+    else if (dest < src)
+    {
+        for (size_t index = 0; index < quantity; ++index)
+        {
+            dest[index] = my_move(src[index]);
+        }
+    }
+    else
     {
-        long long shift = from_left_to_right ? -counter : counter;
+        for (size_t index = quantity; index > 0; --index)
+        {
+            dest[index - 1] = my_move(src[index - 1]);
+        }
     }
 }
 
-// template<typename Type>
-// void copy_data_to_uninit_place(Type *dest,)
-
 #endif
@@ -0,0 +1,328 @@
+#ifndef NULLABLE_VECTOR_HPP
+#define NULLABLE_VECTOR_HPP
+
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <optional>
+#include <utility>
+#include "bitvector.hpp"
+#include "bitwords.hpp"
+#include "vector.hpp"
+
+
+// Column of optional values: the values sit densely in a Vector<Type> (a null keeps a
+// default-constructed placeholder) and validity is a packed Vector<bool>, so the scan
+// kernels walk validity a word at a time and skip 64 nulls with a single test
+template<typename Type>
+class NullableVector
+{
+public:
+    using value_type = Type;
+//---------------------------------------------------------------------------------
+    NullableVector() = default;
+
+    NullableVector(const std::initializer_list<std::optional<Type>> &init_list)
+    {
+        for (const std::optional<Type> &value : init_list)
+        {
+            push_back(value);
+        }
+    }
+//--------------------------------Size and capacity--------------------------------
+    bool empty() const
+    {
+        return values_.empty();
+    }
+
+    size_t size() const
+    {
+        return values_.size();
+    }
+
+    size_t null_count() const
+    {
+        return null_count_;
+    }
+
+    void reserve(size_t reserved_capacity)
+    {
+        values_.reserve(reserved_capacity);
+        validity_.reserve(reserved_capacity);
+    }
+//-------------------------------Element access------------------------------------
+    bool is_valid(size_t index) const
+    {
+        return validity_.test(index);
+    }
+
+    bool is_null(size_t index) const
+    {
+        return !validity_.test(index);
+    }
+
+    // the stored placeholder for nulls, no validity check
+    const Type &value(size_t index) const
+    {
+        return values_[index];
+    }
+
+    std::optional<Type> operator [](size_t index) const
+    {
+        if (!is_valid(index))
+        {
+            return std::nullopt;
+        }
+
+        return values_[index];
+    }
+
+    const Vector<Type> &values() const
+    {
+        return values_;
+    }
+
+    const Vector<bool> &validity() const
+    {
+        return validity_;
+    }
+//----------------------------------Modifiers--------------------------------------
+    void push_back(const Type &value)
+    {
+        values_.push_back(value);
+        validity_.push_back(true);
+    }
+
+    void push_back(const std::optional<Type> &value)
+    {
+        if (value.has_value())
+        {
+            push_back(*value);
+        }
+        else
+        {
+            push_null();
+        }
+    }
+
+    void push_null()
+    {
+        values_.push_back(Type());
+        validity_.push_back(false);
+
+        ++null_count_;
+    }
+
+    void pop_back()
+    {
+        if (empty())
+        {
+            std::cerr << "ERROR(NullableVector " << this << "): null pop attempt" << std::endl;
+
+            return;
+        }
+
+        if (!validity_.back())
+        {
+            --null_count_;
+        }
+
+        values_.pop_back();
+        validity_.pop_back();
+    }
+
+    void set(size_t index, const Type &value)
+    {
+        if (!validity_.test(index))
+        {
+            validity_.set(index);
+            --null_count_;
+        }
+
+        values_[index] = value;
+    }
+
+    void set_null(size_t index)
+    {
+        if (validity_.test(index))
+        {
+            validity_.reset(index);
+            values_[index] = Type();
+            ++null_count_;
+        }
+    }
+
+    void clear()
+    {
+        values_.clear();
+        validity_.clear();
+
+        null_count_ = 0;
+    }
+
+    void swap(NullableVector &other)
+    {
+        values_.swap(other.values_);
+        validity_.swap(other.validity_);
+        std::swap(null_count_, other.null_count_);
+    }
+//----------------------------------Scan kernels-----------------------------------
+    // sum of the valid values; fully valid words run as a plain loop the compiler vectorizes
+    template<typename Accumulator = Type>
+    Accumulator sum() const
+    {
+        Accumulator result = Accumulator();
+        for_each_valid_run_([&result](const Type *values, size_t quantity)
+        {
+            for (size_t index = 0; index < quantity; ++index)
+            {
+                result += values[index];
+            }
+        });
+
+        return result;
+    }
+
+    std::optional<Type> min() const
+    {
+        std::optional<Type> result;
+        for_each_valid_run_([&result](const Type *values, size_t quantity)
+        {
+            Type run_min = values[0];
+            for (size_t index = 1; index < quantity; ++index)
+            {
+                run_min = (values[index] < run_min) ? values[index] : run_min;
+            }
+
+            if (!result.has_value() || (run_min < *result))
+            {
+                result = run_min;
+            }
+        });
+
+        return result;
+    }
+
+    std::optional<Type> max() const
+    {
+        std::optional<Type> result;
+        for_each_valid_run_([&result](const Type *values, size_t quantity)
+        {
+            Type run_max = values[0];
+            for (size_t index = 1; index < quantity; ++index)
+            {
+                run_max = (run_max < values[index]) ? values[index] : run_max;
+            }
+
+            if (!result.has_value() || (*result < run_max))
+            {
+                result = run_max;
+            }
+        });
+
+        return result;
+    }
+
+    // rows whose selection bit is set, nulls stay nulls; empty selection words are skipped
+    NullableVector filter(const Vector<bool> &selection) const
+    {
+        assert(selection.size() == size());
+
+        NullableVector result;
+
+        size_t words = selection.words_quantity();
+        for (size_t word = 0; word < words; ++word)
+        {
+            uint64_t selected = selection.get_word(word);
+            uint64_t valid    = validity_.get_word(word);
+            while (selected != 0)
+            {
+                size_t index_in_word = static_cast<size_t> (std::countl_zero(selected));
+                size_t index = (word << BITS_TO_WORDS_OFFSET) + index_in_word;
+
+                if ((valid & bit_in_word_mask(index_in_word)) != 0)
+                {
+                    result.push_back(values_[index]);
+                }
+                else
+                {
+                    result.push_null();
+                }
+
+                selected ^= bit_in_word_mask(index_in_word);
+            }
+        }
+
+        return result;
+    }
+
+    // valid values only, selected by a predicate
+    template<typename Predicate>
+    Vector<Type> filter_values(Predicate predicate) const
+    {
+        Vector<Type> result;
+        for_each_valid_run_([&result, &predicate](const Type *values, size_t quantity)
+        {
+            for (size_t index = 0; index < quantity; ++index)
+            {
+                if (predicate(values[index]))
+                {
+                    result.push_back(values[index]);
+                }
+            }
+        });
+
+        return result;
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    // calls visitor(values, quantity) for maximal runs of valid values inside each word
+    template<typename Visitor>
+    void for_each_valid_run_(Visitor visitor) const
+    {
+        const Type *values = values_.data();
+
+        size_t words = validity_.words_quantity();
+        for (size_t word = 0; word < words; ++word)
+        {
+            uint64_t valid = validity_.get_word(word);
+            if (valid == 0)
+            {
+                continue;
+            }
+
+            const Type *word_values = values + (word << BITS_TO_WORDS_OFFSET);
+            if (valid == ~0ull)
+            {
+                visitor(word_values, BITS_IN_WORD);
+
+                continue;
+            }
+
+            while (valid != 0)
+            {
+                size_t run_begin = static_cast<size_t> (std::countl_zero(valid));
+                size_t run_end   = run_begin + static_cast<size_t> (std::countl_one(valid << run_begin));
+
+                visitor(word_values + run_begin, run_end - run_begin);
+
+                valid &= ~leading_bits_mask(run_end);
+            }
+        }
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    Vector<Type> values_;
+    Vector<bool> validity_;
+
+    size_t null_count_ = 0;
+};
+
+
+#endif
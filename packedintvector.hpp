@@ -0,0 +1,449 @@
+#ifndef PACKED_INT_VECTOR_HPP
+#define PACKED_INT_VECTOR_HPP
+
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "bitwords.hpp"
+#include "specialvalues.hpp"
+#include "vector.hpp"
+
+
+const size_t MAX_PACKED_INT_WIDTH  = 32;
+const size_t MAX_SHUFFLE_INT_WIDTH = 25;        // 7 bits of misalignment plus the value still fit a 32-bit lane
+
+
+// Unsigned integers of width bits stored back to back: element i occupies bits
+// [i * width, (i + 1) * width) of a little-endian word stream, so a value may straddle two
+// words. Bits != 0 fixes the width at compile time, Bits == 0 takes it in the constructor
+template<size_t Bits = 0>
+class PackedIntVector
+{
+    static_assert(Bits <= MAX_PACKED_INT_WIDTH, "PackedIntVector holds at most 32-bit values");
+
+public:
+    class Reference
+    {
+    public:
+//---------------------------------------------------------------------------------
+        Reference(PackedIntVector *container, size_t index)
+          : container_(container),
+            index_(index)
+        {
+            assert(container != nullptr);
+        }
+
+        Reference(const Reference &other) = default;
+
+        Reference &operator =(uint32_t value)
+        {
+            container_->set(index_, value);
+
+            return *this;
+        }
+
+        Reference &operator =(const Reference &other)
+        {
+            *this = static_cast<uint32_t> (other);
+
+            return *this;
+        }
+
+        ~Reference()
+        {
+            container_ = const_cast<PackedIntVector *> (reinterpret_cast<const PackedIntVector *> (DESTR_PTR));
+            index_     = POISONED_UINT64_T;
+        }
+//---------------------------------------------------------------------------------
+        operator uint32_t() const
+        {
+            return container_->get(index_);
+        }
+
+    private:
+//----------------------------------Variables--------------------------------------
+        PackedIntVector *container_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    using value_type = uint32_t;
+    using reference  = Reference;
+//---------------------------------------------------------------------------------
+    PackedIntVector(size_t size = 0, uint32_t value = 0) requires (Bits != 0)
+      : width_(Bits)
+    {
+        resize(size, value);
+    }
+
+    PackedIntVector(size_t width, size_t size = 0, uint32_t value = 0) requires (Bits == 0)
+      : width_(width)
+    {
+        if ((width == 0) || (width > MAX_PACKED_INT_WIDTH))
+        {
+            std::cerr << "ERROR(PackedIntVector " << this << "): width must be in [1, 32], got " << width << std::endl;
+
+            width_ = MAX_PACKED_INT_WIDTH;
+        }
+
+        resize(size, value);
+    }
+
+    PackedIntVector(const PackedIntVector &other)
+      : width_(other.width_),
+        capacity_(other.capacity_),
+        size_(other.size_),
+        words_(other.words_ != nullptr ? new uint64_t[other.allocated_words_()] : nullptr)
+    {
+        if (words_ != nullptr)
+        {
+            std::memcpy(words_, other.words_, allocated_words_() * sizeof(uint64_t));
+        }
+    }
+
+    PackedIntVector(PackedIntVector &&other)
+      : width_(other.width_)
+    {
+        swap(other);
+    }
+
+    PackedIntVector &operator =(const PackedIntVector &other)
+    {
+        PackedIntVector copy(other);
+        swap(copy);
+
+        return *this;
+    }
+
+    PackedIntVector &operator =(PackedIntVector &&other)
+    {
+        swap(other);
+
+        return *this;
+    }
+
+    ~PackedIntVector()
+    {
+        delete [] words_;
+
+        words_ = const_cast<uint64_t *> (reinterpret_cast<const uint64_t *> (DESTR_PTR));
+        size_  = POISONED_UINT64_T;
+    }
+//--------------------------------Size and capacity--------------------------------
+    size_t width() const
+    {
+        if constexpr (Bits != 0)
+        {
+            return Bits;
+        }
+        else
+        {
+            return width_;
+        }
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    size_t memory_usage() const
+    {
+        return allocated_words_() * sizeof(uint64_t);
+    }
+
+    void reserve(size_t reserved_capacity)
+    {
+        if (reserved_capacity <= capacity_)
+        {
+            return;
+        }
+
+        size_t new_words_quantity = words_for_(reserved_capacity);
+        uint64_t *new_words = new uint64_t[new_words_quantity]{};
+        if (words_ != nullptr)
+        {
+            std::memcpy(new_words, words_, bits_to_words_quantity(size_ * width()) * sizeof(uint64_t));
+            delete [] words_;
+        }
+
+        words_    = new_words;
+        capacity_ = reserved_capacity;
+    }
+//-------------------------------Element access------------------------------------
+    uint32_t get(size_t index) const
+    {
+        assert(index < size_);
+
+        size_t position = index * width();
+        size_t word     = position >> BITS_TO_WORDS_OFFSET;
+        size_t shift    = position & WORD_BITS_MASK;
+
+        uint64_t value = (words_[word] >> shift) | ((words_[word + 1] << 1) << (WORD_BITS_MASK - shift));      // the padding word makes word + 1 always readable
+
+        return static_cast<uint32_t> (value & value_mask_());
+    }
+
+    void set(size_t index, uint32_t value)
+    {
+        assert(index < size_);
+        assert((value & ~value_mask_()) == 0);
+
+        size_t position = index * width();
+        size_t word     = position >> BITS_TO_WORDS_OFFSET;
+        size_t shift    = position & WORD_BITS_MASK;
+
+        size_t   spill  = WORD_BITS_MASK - shift;                                    // high part is empty unless the value straddles
+        uint64_t mask   = value_mask_();
+        uint64_t masked = value & mask;
+
+        words_[word]     = (words_[word]     & ~(mask << shift))        | (masked << shift);
+        words_[word + 1] = (words_[word + 1] & ~((mask >> 1) >> spill)) | ((masked >> 1) >> spill);
+    }
+
+    uint32_t operator [](size_t index) const
+    {
+        return get(index);
+    }
+
+    Reference operator [](size_t index)
+    {
+        return Reference(this, index);
+    }
+
+    uint32_t front() const
+    {
+        return get(0);
+    }
+
+    uint32_t back() const
+    {
+        return get(size_ - 1);
+    }
+
+    const uint64_t *data() const
+    {
+        return words_;
+    }
+//----------------------------------Modifiers--------------------------------------
+    void push_back(uint32_t value)
+    {
+        if (size_ == capacity_)
+        {
+            reserve(capacity_ > 0 ? capacity_ * DEFAULT_RESIZE_MULTIPLIER : 1);
+        }
+
+        set(size_++, value);
+    }
+
+    void pop_back()
+    {
+        if (size_ == 0)
+        {
+            std::cerr << "ERROR(PackedIntVector " << this << "): null pop attempt" << std::endl;
+
+            return;
+        }
+
+        --size_;
+    }
+
+    void resize(size_t new_size, uint32_t value = 0)
+    {
+        reserve(new_size);
+
+        size_t old_size = size_;
+        size_ = new_size;
+        for (size_t index = old_size; index < new_size; ++index)
+        {
+            set(index, value);
+        }
+    }
+
+    void clear()
+    {
+        size_ = 0;
+    }
+
+    void swap(PackedIntVector &other)
+    {
+        std::swap(width_,    other.width_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_,     other.size_);
+        std::swap(words_,    other.words_);
+    }
+//--------------------------------Bulk conversion----------------------------------
+    // count elements starting from first into destination
+    void unpack(size_t first, size_t count, uint32_t *destination) const
+    {
+        assert(first + count <= size_);
+        assert((destination != nullptr) || (count == 0));
+
+        size_t index = first;
+        size_t last  = first + count;
+
+#ifdef __AVX2__
+        if ((width() <= MAX_SHUFFLE_INT_WIDTH) && (std::endian::native == std::endian::little))
+        {
+            for (; (index < last) && ((index & 7) != 0); ++index)
+            {
+                *destination++ = get(index);
+            }
+
+            size_t groups = (last - index) >> 3;
+            unpack_avx2_(index, groups, destination);
+
+            index       += groups << 3;
+            destination += groups << 3;
+        }
+#endif
+
+        for (; index < last; ++index)
+        {
+            *destination++ = get(index);
+        }
+    }
+
+    Vector<uint32_t> unpack() const
+    {
+        Vector<uint32_t> result(size_);
+        if (size_ != 0)
+        {
+            unpack(0, size_, result.data());
+        }
+
+        return result;
+    }
+
+    // replaces the contents, whole words are assembled in a register and stored once
+    void pack(const uint32_t *values, size_t count)
+    {
+        assert((values != nullptr) || (count == 0));
+
+        size_ = 0;
+        reserve(count);
+        size_ = count;
+
+        size_t   bits   = width();
+        uint64_t mask   = value_mask_();
+        uint64_t buffer = 0;
+        size_t   filled = 0;
+        size_t   word   = 0;
+        for (size_t index = 0; index < count; ++index)
+        {
+            uint64_t value = values[index] & mask;
+
+            buffer |= value << filled;
+            filled += bits;
+            if (filled >= BITS_IN_WORD)
+            {
+                words_[word++] = buffer;
+
+                filled -= BITS_IN_WORD;
+                buffer  = (filled != 0) ? value >> (bits - filled) : 0;
+            }
+        }
+
+        if (filled != 0)
+        {
+            words_[word] = buffer;
+        }
+    }
+
+    void pack(const Vector<uint32_t> &values)
+    {
+        pack(values.empty() ? nullptr : values.data(), values.size());
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    uint64_t value_mask_() const
+    {
+        return (0x1ull << width()) - 1;
+    }
+
+    size_t words_for_(size_t elements_quantity) const
+    {
+        return bits_to_words_quantity(elements_quantity * width()) + PADDING_WORDS;
+    }
+
+    size_t allocated_words_() const
+    {
+        return words_ != nullptr ? words_for_(capacity_) : 0;
+    }
+
+#ifdef __AVX2__
+    // eight elements per step, first a multiple of 8 so that the group starts on a byte;
+    // each 128-bit half loads 16 bytes from the byte holding its first element and a byte
+    // shuffle brings every value's four bytes into its own 32-bit lane
+    void unpack_avx2_(size_t first, size_t groups, uint32_t *destination) const
+    {
+        size_t bits = width();
+        size_t high_half_byte = (4 * bits) >> 3;
+
+        alignas(32) uint8_t  shuffle[32] = {};
+        alignas(32) uint32_t shifts[8]   = {};
+        for (size_t element = 0; element < 8; ++element)
+        {
+            size_t position = element * bits;
+            size_t byte     = (position >> 3) - ((element < 4) ? 0 : high_half_byte);
+            for (size_t byte_in_lane = 0; byte_in_lane < 4; ++byte_in_lane)
+            {
+                shuffle[element * 4 + byte_in_lane] = static_cast<uint8_t> (byte + byte_in_lane);
+            }
+
+            shifts[element] = static_cast<uint32_t> (position & 7);
+        }
+
+        const __m256i shuffle_control = _mm256_load_si256(reinterpret_cast<const __m256i *> (shuffle));
+        const __m256i shift_counts    = _mm256_load_si256(reinterpret_cast<const __m256i *> (shifts));
+        const __m256i mask            = _mm256_set1_epi32(static_cast<int> (value_mask_()));
+
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *> (words_);
+        for (size_t group = 0; group < groups; ++group)
+        {
+            const uint8_t *group_bytes = bytes + (((first + (group << 3)) * bits) >> 3);
+
+            __m256i lanes = _mm256_set_m128i(_mm_loadu_si128(reinterpret_cast<const __m128i *> (group_bytes + high_half_byte)),
+                                             _mm_loadu_si128(reinterpret_cast<const __m128i *> (group_bytes)));
+
+            lanes = _mm256_shuffle_epi8(lanes, shuffle_control);
+            lanes = _mm256_and_si256(_mm256_srlv_epi32(lanes, shift_counts), mask);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i *> (destination + (group << 3)), lanes);
+        }
+    }
+#endif
+
+private:
+//-----------------------------------Variables-------------------------------------
+    static constexpr size_t PADDING_WORDS             = 4;     // one for straddling reads, room for the 16-byte shuffle loads
+    static constexpr size_t DEFAULT_RESIZE_MULTIPLIER = 2;
+
+    size_t width_    = Bits;
+    size_t capacity_ = 0;
+    size_t size_     = 0;
+
+    uint64_t *words_ = nullptr;
+};
+
+
+#endif
@@ -1,48 +1,14 @@
-#include <cassert>
-#include <iostream>
+#include "print.hpp"
 
 
-void print(const char *format)
-{
-    assert(format != nullptr);
-
-    std::cout << format;
-}
-
-template <typename T, typename... ArgsT>
-void print(const char *format, T arg, ArgsT... args)
-{
-    assert(format != nullptr);
-
-    while (*format != '\0')
-    {
-        if (*format == '%')
-        {
-            if (*(format + 1) != '%')
-            {
-                std::cout << arg;
-
-                print(format + 1, args...);
-
-                return;
-            }
-
-            ++format;
-        }
-
-        std::putchar(*format);
-
-        ++format;
-    }
-}
-
 int main()
 {
     int arg1 = 228;
     int arg2 = 1488;
     int arg3 = 1337;
 
-    print( "here should be percent: %%, num1:% num2:% num3:%\n", arg1, arg2, arg3);
+    print("here should be braces: {{}}, num1:{} num2:{:>6} num3:{:x}\n", arg1, arg2, arg3);
+    print("float: {:.3f}, padded: [{:^9}], text: {:.4}\n", 3.14159, "mid", "truncated");
 
     return 0;    
 }
@@ -0,0 +1,692 @@
+#ifndef PRINT_HPP
+#define PRINT_HPP
+
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <unistd.h>
+
+
+const size_t PRINT_BUFFER_SIZE   = 4096;
+const size_t MAX_PRINT_PRECISION = 128;        // keeps a fixed-notation double within the conversion buffer
+
+
+// Destination of print_to: a caller-provided array that is either flushed to a FILE or a file
+// descriptor when it fills up or, without a sink, keeps the leading part and reports truncated()
+class PrintBuffer
+{
+public:
+//---------------------------------------------------------------------------------
+    PrintBuffer(char *data, size_t capacity, FILE *sink = nullptr)
+      : data_(data),
+        capacity_(capacity),
+        sink_(sink)
+    {
+        assert((data != nullptr) || (capacity == 0));
+    }
+
+    PrintBuffer(char *data, size_t capacity, int fd)
+      : data_(data),
+        capacity_(capacity),
+        fd_(fd)
+    {
+        assert((data != nullptr) || (capacity == 0));
+        assert(fd >= 0);
+    }
+
+    PrintBuffer(const PrintBuffer &other) = delete;
+    PrintBuffer &operator =(const PrintBuffer &other) = delete;
+//---------------------------------------------------------------------------------
+    void append(const char *text, size_t length)
+    {
+        if (length <= capacity_ - size_)
+        {
+            std::memcpy(data_ + size_, text, length);
+            size_ += length;
+
+            return;
+        }
+
+        append_slow_(text, length);
+    }
+
+    void append(char symbol, size_t count = 1)
+    {
+        while (count > 0)
+        {
+            if (size_ == capacity_)
+            {
+                if (!make_room_())
+                {
+                    return;
+                }
+            }
+
+            size_t chunk = std::min(count, capacity_ - size_);
+            std::memset(data_ + size_, symbol, chunk);
+            size_ += chunk;
+            count -= chunk;
+        }
+    }
+
+    void append(std::string_view text)
+    {
+        append(text.data(), text.size());
+    }
+
+    // at least bytes of contiguous free space to be filled and then commit()ted, flushing
+    // first if needed; nullptr when there is no sink to make room or bytes exceeds capacity()
+    char *prepare(size_t bytes)
+    {
+        if ((bytes > capacity_ - size_) && ((bytes > capacity_) || !make_room_()))
+        {
+            truncated_ = true;
+
+            return nullptr;
+        }
+
+        return data_ + size_;
+    }
+
+    void commit(size_t bytes)
+    {
+        assert(bytes <= capacity_ - size_);
+
+        size_ += bytes;
+    }
+
+    // writes the contents to the sink in one call
+    void flush()
+    {
+        if (size_ > 0)
+        {
+            write_out_(data_, size_);
+        }
+
+        size_ = 0;
+    }
+
+    void clear()
+    {
+        size_      = 0;
+        truncated_ = false;
+        failed_    = false;
+    }
+//---------------------------------------------------------------------------------
+    const char *data() const
+    {
+        return data_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    std::string_view view() const
+    {
+        return std::string_view(data_, size_);
+    }
+
+    bool truncated() const
+    {
+        return truncated_;
+    }
+
+    FILE *sink() const
+    {
+        return sink_;
+    }
+
+    // a write to the sink has failed, what followed was discarded
+    bool failed() const
+    {
+        return failed_;
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    bool has_sink_() const
+    {
+        return (sink_ != nullptr) || (fd_ >= 0);
+    }
+
+    bool make_room_()
+    {
+        if (!has_sink_())
+        {
+            truncated_ = true;
+
+            return false;
+        }
+
+        flush();
+
+        return capacity_ > 0;
+    }
+
+    void write_out_(const char *text, size_t length)
+    {
+        if (failed_)
+        {
+            return;
+        }
+
+        if (sink_ != nullptr)
+        {
+            failed_ = std::fwrite(text, 1, length, sink_) != length;
+
+            return;
+        }
+
+        while ((fd_ >= 0) && (length > 0))
+        {
+            ssize_t written = write(fd_, text, length);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                failed_ = true;
+
+                return;
+            }
+
+            text   += written;
+            length -= static_cast<size_t> (written);
+        }
+    }
+
+    void append_slow_(const char *text, size_t length)
+    {
+        if (has_sink_())
+        {
+            flush();
+            if (length > capacity_)
+            {
+                write_out_(text, length);
+
+                return;
+            }
+        }
+        else
+        {
+            length     = capacity_ - size_;
+            truncated_ = true;
+        }
+
+        std::memcpy(data_ + size_, text, length);
+        size_ += length;
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    char *data_ = nullptr;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+    bool truncated_ = false;
+    bool failed_ = false;
+
+    FILE *sink_ = nullptr;
+    int fd_ = -1;
+};
+
+
+// {[:[align][0][width][.precision][type]]}, align one of '<' '>' '^', type one of
+// d x X b o for integers, f e g a for floating point, s for strings, c for chars
+struct FormatSpec
+{
+    size_t width = 0;
+    size_t precision = 0;
+    bool has_precision = false;
+    bool zero_pad = false;
+    char align = '\0';
+    char type = '\0';
+};
+
+enum class PrintCategory
+{
+    INTEGER,
+    FLOATING,
+    BOOLEAN,
+    CHARACTER,
+    STRING,
+    POINTER,
+    UNSUPPORTED
+};
+
+template<typename Type>
+consteval PrintCategory print_category()
+{
+    using Decayed = std::decay_t<Type>;
+
+    if constexpr (std::is_same_v<Decayed, bool>)                                                 return PrintCategory::BOOLEAN;
+    else if constexpr (std::is_same_v<Decayed, char>)                                            return PrintCategory::CHARACTER;
+    else if constexpr (std::is_integral_v<Decayed>)                                              return PrintCategory::INTEGER;
+    else if constexpr (std::is_floating_point_v<Decayed>)                                        return PrintCategory::FLOATING;
+    else if constexpr (std::is_same_v<Decayed, const char *> || std::is_same_v<Decayed, char *>) return PrintCategory::STRING;
+    else if constexpr (std::is_convertible_v<const Decayed &, std::string_view>)                  return PrintCategory::STRING;
+    else if constexpr (std::is_pointer_v<Decayed> || std::is_null_pointer_v<Decayed>)             return PrintCategory::POINTER;
+    else                                                                                          return PrintCategory::UNSUPPORTED;
+}
+
+// not constexpr: reaching it while parsing at compile time makes the message the diagnostic
+inline void format_error(const char * /* message */)
+{}
+
+
+// Format string checked and split while compiling: literal pieces between the placeholders
+// and one FormatSpec per argument, validated against the argument's type
+template<typename... ArgsT>
+class BasicFormatString
+{
+    static constexpr size_t ARGS_QUANTITY = sizeof...(ArgsT);
+
+public:
+    struct Piece
+    {
+        const char *begin = nullptr;
+        size_t length = 0;
+        bool escaped = false;                   // holds {{ or }} that print as one brace
+    };
+//---------------------------------------------------------------------------------
+    template<typename StringType>
+        requires std::convertible_to<const StringType &, std::string_view>
+    consteval BasicFormatString(const StringType &format)
+    {
+        std::string_view text = format;
+        constexpr PrintCategory categories[ARGS_QUANTITY + 1] = {print_category<ArgsT>()..., PrintCategory::UNSUPPORTED};
+
+        size_t placeholder = 0;
+        size_t position = 0;
+        pieces_[0].begin = text.data();
+        while (position < text.size())
+        {
+            char symbol = text[position];
+            if ((symbol == '}') && ((position + 1 == text.size()) || (text[position + 1] != '}')))
+            {
+                format_error("unmatched } in format string");
+            }
+
+            if ((symbol != '{') || ((position + 1 < text.size()) && (text[position + 1] == '{')))
+            {
+                if ((symbol == '{') || (symbol == '}'))
+                {
+                    pieces_[placeholder].escaped = true;
+                    ++pieces_[placeholder].length;
+                    ++position;
+                }
+
+                ++pieces_[placeholder].length;
+                ++position;
+
+                continue;
+            }
+
+            if (placeholder == ARGS_QUANTITY)
+            {
+                format_error("more placeholders than arguments");
+            }
+
+            position = parse_spec_(text, position + 1, specs_[placeholder]);
+            check_spec_(specs_[placeholder], categories[placeholder]);
+
+            ++placeholder;
+            pieces_[placeholder].begin = text.data() + position;
+        }
+
+        if (placeholder != ARGS_QUANTITY)
+        {
+            format_error("fewer placeholders than arguments");
+        }
+    }
+//---------------------------------------------------------------------------------
+    const Piece &piece(size_t index) const
+    {
+        return pieces_[index];
+    }
+
+    const FormatSpec &spec(size_t index) const
+    {
+        return specs_[index];
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    // position just after the opening brace, returns the one after the closing brace
+    static consteval size_t parse_spec_(std::string_view text, size_t position, FormatSpec &spec)
+    {
+        if ((position < text.size()) && (text[position] == ':'))
+        {
+            ++position;
+            if ((position < text.size()) && ((text[position] == '<') || (text[position] == '>') || (text[position] == '^')))
+            {
+                spec.align = text[position++];
+            }
+            if ((position < text.size()) && (text[position] == '0'))
+            {
+                spec.zero_pad = true;
+                ++position;
+            }
+
+            position = parse_number_(text, position, spec.width);
+            if ((position < text.size()) && (text[position] == '.'))
+            {
+                size_t digits_begin = position + 1;
+
+                spec.has_precision = true;
+                position = parse_number_(text, digits_begin, spec.precision);
+                if (position == digits_begin)
+                {
+                    format_error("missing precision after '.'");
+                }
+                if (spec.precision > MAX_PRINT_PRECISION)
+                {
+                    format_error("precision is too large");
+                }
+            }
+
+            if ((position < text.size()) && (text[position] != '}'))
+            {
+                spec.type = text[position++];
+            }
+        }
+
+        if ((position >= text.size()) || (text[position] != '}'))
+        {
+            format_error("placeholder is not closed by }");
+        }
+
+        return position + 1;
+    }
+
+    static consteval size_t parse_number_(std::string_view text, size_t position, size_t &number)
+    {
+        number = 0;
+        while ((position < text.size()) && (text[position] >= '0') && (text[position] <= '9'))
+        {
+            number = number * 10 + static_cast<size_t> (text[position++] - '0');
+        }
+
+        return position;
+    }
+
+    static consteval void check_spec_(const FormatSpec &spec, PrintCategory category)
+    {
+        std::string_view allowed;
+        switch (category)
+        {
+            case PrintCategory::INTEGER:     allowed = "dxXbo";  break;
+            case PrintCategory::FLOATING:    allowed = "fega";   break;
+            case PrintCategory::BOOLEAN:     allowed = "s";      break;
+            case PrintCategory::CHARACTER:   allowed = "c";      break;
+            case PrintCategory::STRING:      allowed = "s";      break;
+            case PrintCategory::POINTER:     allowed = "";       break;
+            case PrintCategory::UNSUPPORTED: format_error("argument type cannot be printed"); break;
+        }
+
+        if ((spec.type != '\0') && (allowed.find(spec.type) == std::string_view::npos))
+        {
+            format_error("presentation type does not fit the argument");
+        }
+        if (spec.has_precision && (category != PrintCategory::FLOATING) && (category != PrintCategory::STRING))
+        {
+            format_error("precision is only meaningful for floating point and strings");
+        }
+        if (spec.zero_pad && (category != PrintCategory::INTEGER) && (category != PrintCategory::FLOATING))
+        {
+            format_error("zero padding is only meaningful for numbers");
+        }
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    std::array<Piece, ARGS_QUANTITY + 1> pieces_ = {};
+    std::array<FormatSpec, ARGS_QUANTITY> specs_ = {};
+};
+
+template<typename... ArgsT>
+using FormatString = BasicFormatString<std::type_identity_t<ArgsT>...>;
+
+
+namespace print_detail
+{
+    // pads body to spec.width, numbers go right and after their sign when zero padded
+    inline void append_padded(PrintBuffer &buffer, const char *body, size_t length, const FormatSpec &spec, bool numeric)
+    {
+        if (length >= spec.width)
+        {
+            buffer.append(body, length);
+
+            return;
+        }
+
+        size_t padding = spec.width - length;
+        if (spec.zero_pad && (spec.align == '\0'))
+        {
+            size_t sign = ((length > 0) && ((body[0] == '-') || (body[0] == '+'))) ? 1 : 0;
+
+            buffer.append(body, sign);
+            buffer.append('0', padding);
+            buffer.append(body + sign, length - sign);
+
+            return;
+        }
+
+        char align = (spec.align != '\0') ? spec.align : (numeric ? '>' : '<');
+        size_t before = (align == '>') ? padding : (align == '^') ? padding / 2 : 0;
+
+        buffer.append(' ', before);
+        buffer.append(body, length);
+        buffer.append(' ', padding - before);
+    }
+
+    template<typename Type>
+    void append_value(PrintBuffer &buffer, const Type &value, const FormatSpec &spec)
+    {
+        constexpr PrintCategory CATEGORY = print_category<Type>();
+
+        char digits[MAX_PRINT_PRECISION + 352];         // any double in fixed notation fits
+        char *end = digits;
+
+        if constexpr (CATEGORY == PrintCategory::INTEGER)
+        {
+            int base = (spec.type == 'x' || spec.type == 'X') ? 16 : (spec.type == 'b') ? 2 : (spec.type == 'o') ? 8 : 10;
+            end = std::to_chars(digits, digits + sizeof(digits), value, base).ptr;
+            if (spec.type == 'X')
+            {
+                for (char *symbol = digits; symbol != end; ++symbol)
+                {
+                    *symbol = ((*symbol >= 'a') && (*symbol <= 'f')) ? static_cast<char> (*symbol - 'a' + 'A') : *symbol;
+                }
+            }
+
+            append_padded(buffer, digits, static_cast<size_t> (end - digits), spec, true);
+        }
+        else if constexpr (CATEGORY == PrintCategory::FLOATING)
+        {
+            std::chars_format format = (spec.type == 'f') ? std::chars_format::fixed      :
+                                       (spec.type == 'e') ? std::chars_format::scientific :
+                                       (spec.type == 'a') ? std::chars_format::hex        : std::chars_format::general;
+
+            std::to_chars_result result = {};
+            if (spec.has_precision)
+            {
+                result = std::to_chars(digits, digits + sizeof(digits), value, format, static_cast<int> (spec.precision));
+            }
+            else if (spec.type != '\0')
+            {
+                result = std::to_chars(digits, digits + sizeof(digits), value, format);
+            }
+            else
+            {
+                result = std::to_chars(digits, digits + sizeof(digits), value);
+            }
+            if (result.ec != std::errc())
+            {
+                result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::scientific);       // long double too wide for fixed
+            }
+            end = result.ptr;
+
+            append_padded(buffer, digits, static_cast<size_t> (end - digits), spec, true);
+        }
+        else if constexpr (CATEGORY == PrintCategory::BOOLEAN)
+        {
+            append_padded(buffer, value ? "true" : "false", value ? 4 : 5, spec, false);
+        }
+        else if constexpr (CATEGORY == PrintCategory::CHARACTER)
+        {
+            append_padded(buffer, &value, 1, spec, false);
+        }
+        else if constexpr (CATEGORY == PrintCategory::STRING)
+        {
+            std::string_view text;
+            if constexpr (std::is_pointer_v<Type>)
+            {
+                text = (value != nullptr) ? std::string_view(value) : std::string_view("(null)");
+            }
+            else
+            {
+                text = value;
+            }
+            if (spec.has_precision && (spec.precision < text.size()))
+            {
+                text = text.substr(0, spec.precision);
+            }
+
+            append_padded(buffer, text.data(), text.size(), spec, false);
+        }
+        else if constexpr (CATEGORY == PrintCategory::POINTER)
+        {
+            digits[0] = '0';
+            digits[1] = 'x';
+            end = std::to_chars(digits + 2, digits + sizeof(digits), reinterpret_cast<uintptr_t> (value), 16).ptr;
+
+            append_padded(buffer, digits, static_cast<size_t> (end - digits), spec, false);
+        }
+    }
+
+    inline void append_piece(PrintBuffer &buffer, const char *begin, size_t length, bool escaped)
+    {
+        if (!escaped)
+        {
+            buffer.append(begin, length);
+
+            return;
+        }
+
+        const char *end = begin + length;
+        while (begin != end)
+        {
+            const char *brace = begin;
+            while ((brace != end) && (*brace != '{') && (*brace != '}'))
+            {
+                ++brace;
+            }
+
+            buffer.append(begin, static_cast<size_t> (brace - begin));
+            if (brace == end)
+            {
+                break;
+            }
+
+            buffer.append(*brace);
+            begin = brace + 2;
+        }
+    }
+
+    template<typename... ArgsT, size_t... Indices>
+    void print_to(PrintBuffer &buffer, const BasicFormatString<ArgsT...> &format, std::index_sequence<Indices...>, const ArgsT &...args)
+    {
+        using Piece = typename BasicFormatString<ArgsT...>::Piece;
+
+        const Piece &first = format.piece(0);
+        append_piece(buffer, first.begin, first.length, first.escaped);
+
+        ([&]
+        {
+            append_value(buffer, args, format.spec(Indices));
+
+            const Piece &next = format.piece(Indices + 1);
+            append_piece(buffer, next.begin, next.length, next.escaped);
+        }(), ...);
+    }
+}
+
+
+// appends to buffer, a format string that does not fit the arguments does not compile
+template<typename... ArgsT>
+void print_to(PrintBuffer &buffer, FormatString<ArgsT...> format, const ArgsT &...args)
+{
+    print_detail::print_to(buffer, format, std::index_sequence_for<ArgsT...>(), args...);
+}
+
+template<typename... ArgsT>
+std::string print_to_string(FormatString<ArgsT...> format, const ArgsT &...args)
+{
+    char storage[PRINT_BUFFER_SIZE];
+    PrintBuffer buffer(storage, sizeof(storage));
+
+    print_detail::print_to(buffer, format, std::index_sequence_for<ArgsT...>(), args...);
+    if (!buffer.truncated())
+    {
+        return std::string(buffer.view());
+    }
+
+    std::string result;
+    result.resize(buffer.size() * 2);
+    while (true)
+    {
+        PrintBuffer growing(result.data(), result.size());
+        print_detail::print_to(growing, format, std::index_sequence_for<ArgsT...>(), args...);
+        if (!growing.truncated())
+        {
+            result.resize(growing.size());
+
+            return result;
+        }
+
+        result.resize(result.size() * 2);
+    }
+}
+
+// the whole message is assembled in a thread-local buffer and handed to the stream at once
+template<typename... ArgsT>
+void print(FILE *stream, FormatString<ArgsT...> format, const ArgsT &...args)
+{
+    assert(stream != nullptr);
+
+    thread_local char storage[PRINT_BUFFER_SIZE];
+    PrintBuffer buffer(storage, sizeof(storage), stream);
+
+    print_detail::print_to(buffer, format, std::index_sequence_for<ArgsT...>(), args...);
+    buffer.flush();
+}
+
+template<typename... ArgsT>
+void print(FormatString<ArgsT...> format, const ArgsT &...args)
+{
+    print(stdout, format, args...);
+}
+
+
+#endif
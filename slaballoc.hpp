@@ -0,0 +1,425 @@
+#ifndef SLAB_ALLOC_HPP
+#define SLAB_ALLOC_HPP
+
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <new>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+#include "dynamicalloc.hpp"
+#include "specialvalues.hpp"
+
+
+const size_t SLAB_MIN_BLOCK_SHIFT  = 4;
+const size_t SLAB_MIN_BLOCK_BYTES  = 1ul << SLAB_MIN_BLOCK_SHIFT;
+const size_t SLAB_MAX_BLOCK_BYTES  = 1ul << 15;
+const size_t SLAB_CLASSES_QUANTITY = std::bit_width(SLAB_MAX_BLOCK_BYTES) - SLAB_MIN_BLOCK_SHIFT;
+const size_t SLAB_BYTES            = 1ul << 18;        // 7 blocks of the largest class after the header
+
+
+// Size-class pool for buffers that are freed and requested again and again. Requests are
+// rounded up to a power of two, which is what calculate_enough_capacity_ hands out for
+// power-of-two element sizes, and every class carves its blocks out of 256 KiB slabs
+// aligned to their own size, so the slab of a block is found by masking its address.
+// Each thread keeps a magazine of free blocks per class and only takes the class lock to
+// refill or drain it; a slab whose blocks have all come back is unmapped once the class
+// already keeps one empty slab in reserve. Larger requests go to the upstream allocator.
+// There is one pool per process, reached through slab_allocator()
+class SlabAlloc : public Allocator
+{
+    struct FreeBlock
+    {
+        FreeBlock *next = nullptr;
+    };
+
+    struct alignas(64) Slab
+    {
+        Slab *prev = nullptr;
+        Slab *next = nullptr;
+
+        FreeBlock *free   = nullptr;            // blocks given back
+        char      *carved = nullptr;            // blocks past this one were never handed out
+
+        size_t block_bytes = 0;
+        size_t live        = 0;                 // blocks out of the slab, magazines included
+    };
+
+    struct SizeClass
+    {
+        std::mutex mutex;
+
+        Slab *partial = nullptr;                // slabs with at least one block to give
+        size_t empty_slabs = 0;
+    };
+
+    struct Magazine
+    {
+        FreeBlock *head = nullptr;
+        size_t count = 0;
+    };
+
+    // flushed back to the pool when its thread exits
+    struct ThreadCache
+    {
+        Magazine magazines[SLAB_CLASSES_QUANTITY];
+
+        ~ThreadCache();
+    };
+
+    friend SlabAlloc *slab_allocator();
+
+public:
+//---------------------------------------------------------------------------------
+    SlabAlloc(const SlabAlloc &other) = delete;
+    SlabAlloc &operator =(const SlabAlloc &other) = delete;
+//---------------------------------------------------------------------------------
+    char *allocate(size_t bytes) override
+    {
+        if (bytes > SLAB_MAX_BLOCK_BYTES)
+        {
+            return upstream_->allocate(bytes);
+        }
+
+        size_t class_index = class_of_(bytes);
+        Magazine &magazine = thread_cache_().magazines[class_index];
+        if (magazine.head == nullptr)
+        {
+            refill_(class_index, magazine);
+        }
+
+        FreeBlock *block = magazine.head;
+        magazine.head = block->next;
+        --magazine.count;
+
+        return reinterpret_cast<char *> (block);
+    }
+
+    void deallocate(char *data, size_t bytes) override
+    {
+        if (data == nullptr)
+        {
+            return;
+        }
+
+        if (bytes > SLAB_MAX_BLOCK_BYTES)
+        {
+            upstream_->deallocate(data, bytes);
+
+            return;
+        }
+
+        size_t class_index = class_of_(bytes);
+        Magazine &magazine = thread_cache_().magazines[class_index];
+
+        FreeBlock *block = new (data) FreeBlock;
+        block->next = magazine.head;
+        magazine.head = block;
+        ++magazine.count;
+
+        if (magazine.count > magazine_capacity_(class_index))
+        {
+            drain_(class_index, magazine, magazine_capacity_(class_index) >> 1);
+        }
+    }
+
+    // whole block of the size class, the upstream decides above SLAB_MAX_BLOCK_BYTES
+    size_t usable_size(size_t bytes) const override
+    {
+        return bytes > SLAB_MAX_BLOCK_BYTES ? upstream_->usable_size(bytes) : block_bytes_(class_of_(bytes));
+    }
+
+    // gives the calling thread's magazines back and unmaps every empty slab
+    void trim()
+    {
+        ThreadCache &cache = thread_cache_();
+        for (size_t class_index = 0; class_index < SLAB_CLASSES_QUANTITY; ++class_index)
+        {
+            drain_(class_index, cache.magazines[class_index], 0);
+
+            SizeClass &size_class = classes_[class_index];
+            std::lock_guard<std::mutex> lock(size_class.mutex);
+
+            Slab *slab = size_class.partial;
+            while (slab != nullptr)
+            {
+                Slab *next = slab->next;
+                if (slab->live == 0)
+                {
+                    unlink_(size_class, slab);
+                    unmap_slab_(slab);
+                }
+
+                slab = next;
+            }
+
+            size_class.empty_slabs = 0;
+        }
+    }
+//---------------------------------------------------------------------------------
+    size_t mapped_bytes() const
+    {
+        return mapped_bytes_.load(std::memory_order_relaxed);
+    }
+
+    static constexpr size_t max_block_size()
+    {
+        return SLAB_MAX_BLOCK_BYTES;
+    }
+
+private:
+//---------------------------------------------------------------------------------
+    SlabAlloc(Allocator *upstream = default_allocator())
+      : upstream_(upstream)
+    {
+        assert(upstream != nullptr);
+    }
+//--------------------------------Utilitary functions------------------------------
+    static size_t class_of_(size_t bytes)
+    {
+        return bytes <= SLAB_MIN_BLOCK_BYTES ? 0 : std::bit_width(bytes - 1) - SLAB_MIN_BLOCK_SHIFT;
+    }
+
+    static size_t block_bytes_(size_t class_index)
+    {
+        return SLAB_MIN_BLOCK_BYTES << class_index;
+    }
+
+    // about MAGAZINE_BYTES worth of blocks, within [MIN_MAGAZINE_BLOCKS, MAX_MAGAZINE_BLOCKS]
+    static size_t magazine_capacity_(size_t class_index)
+    {
+        size_t blocks = MAGAZINE_BYTES / block_bytes_(class_index);
+
+        return blocks < MIN_MAGAZINE_BLOCKS ? MIN_MAGAZINE_BLOCKS :
+               blocks > MAX_MAGAZINE_BLOCKS ? MAX_MAGAZINE_BLOCKS : blocks;
+    }
+
+    static ThreadCache &thread_cache_()
+    {
+        thread_local ThreadCache cache;
+
+        return cache;
+    }
+
+    static Slab *slab_of_(const void *block)
+    {
+        return reinterpret_cast<Slab *> (reinterpret_cast<uintptr_t> (block) & ~(SLAB_BYTES - 1));
+    }
+
+    static bool exhausted_(const Slab *slab)
+    {
+        const char *slab_end = reinterpret_cast<const char *> (slab) + SLAB_BYTES;
+
+        return (slab->free == nullptr) && (static_cast<size_t> (slab_end - slab->carved) < slab->block_bytes);
+    }
+
+    static void link_(SizeClass &size_class, Slab *slab)
+    {
+        slab->prev = nullptr;
+        slab->next = size_class.partial;
+        if (size_class.partial != nullptr)
+        {
+            size_class.partial->prev = slab;
+        }
+
+        size_class.partial = slab;
+    }
+
+    static void unlink_(SizeClass &size_class, Slab *slab)
+    {
+        if (slab->prev != nullptr)
+        {
+            slab->prev->next = slab->next;
+        }
+        else
+        {
+            size_class.partial = slab->next;
+        }
+
+        if (slab->next != nullptr)
+        {
+            slab->next->prev = slab->prev;
+        }
+
+        slab->prev = nullptr;
+        slab->next = nullptr;
+    }
+
+    // half a magazine from the partial slabs, mapping a new slab when they run out
+    void refill_(size_t class_index, Magazine &magazine)
+    {
+        SizeClass &size_class = classes_[class_index];
+        std::lock_guard<std::mutex> lock(size_class.mutex);
+
+        size_t wanted = magazine_capacity_(class_index) >> 1;
+        for (size_t taken = 0; taken < wanted; ++taken)
+        {
+            if (size_class.partial == nullptr)
+            {
+                link_(size_class, map_slab_(class_index));
+                ++size_class.empty_slabs;
+            }
+
+            Slab *slab = size_class.partial;
+            if (slab->live == 0)
+            {
+                --size_class.empty_slabs;
+            }
+
+            FreeBlock *block = slab->free;
+            if (block != nullptr)
+            {
+                slab->free = block->next;
+            }
+            else
+            {
+                block = new (slab->carved) FreeBlock;
+                slab->carved += slab->block_bytes;
+            }
+
+            ++slab->live;
+            if (exhausted_(slab))
+            {
+                unlink_(size_class, slab);
+            }
+
+            block->next = magazine.head;
+            magazine.head = block;
+            ++magazine.count;
+        }
+    }
+
+    // returns blocks to their slabs until keep are left in the magazine
+    void drain_(size_t class_index, Magazine &magazine, size_t keep)
+    {
+        if (magazine.count <= keep)
+        {
+            return;
+        }
+
+        SizeClass &size_class = classes_[class_index];
+        std::lock_guard<std::mutex> lock(size_class.mutex);
+
+        while (magazine.count > keep)
+        {
+            FreeBlock *block = magazine.head;
+            magazine.head = block->next;
+            --magazine.count;
+
+            Slab *slab = slab_of_(block);
+            bool was_exhausted = exhausted_(slab);
+
+            block->next = slab->free;
+            slab->free  = block;
+            --slab->live;
+
+            if (was_exhausted)
+            {
+                link_(size_class, slab);
+            }
+
+            if (slab->live == 0)
+            {
+                if (size_class.empty_slabs >= MAX_EMPTY_SLABS)
+                {
+                    unlink_(size_class, slab);
+                    unmap_slab_(slab);
+                }
+                else
+                {
+                    ++size_class.empty_slabs;
+                }
+            }
+        }
+    }
+
+    Slab *map_slab_(size_t class_index)
+    {
+        void *memory = nullptr;
+
+#if defined(__unix__) || defined(__APPLE__)
+        // twice the size so that an aligned slab fits, then the ends are given back
+        void *mapping = mmap(nullptr, 2 * SLAB_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping != MAP_FAILED)
+        {
+            uintptr_t start   = reinterpret_cast<uintptr_t> (mapping);
+            uintptr_t aligned = (start + SLAB_BYTES - 1) & ~(SLAB_BYTES - 1);
+            if (aligned != start)
+            {
+                munmap(mapping, aligned - start);
+            }
+            munmap(reinterpret_cast<void *> (aligned + SLAB_BYTES), start + SLAB_BYTES - aligned);
+
+            memory = reinterpret_cast<void *> (aligned);
+        }
+#else
+        memory = ::operator new(SLAB_BYTES, std::align_val_t(SLAB_BYTES), std::nothrow);
+#endif
+
+        if (memory == nullptr)
+        {
+            std::cerr << "ERROR(SlabAlloc " << this << "): cannot map a slab of " << SLAB_BYTES << " bytes" << std::endl;
+
+            throw std::bad_alloc();
+        }
+
+        mapped_bytes_.fetch_add(SLAB_BYTES, std::memory_order_relaxed);
+
+        Slab *slab = new (memory) Slab;
+        slab->carved      = reinterpret_cast<char *> (slab) + sizeof(Slab);
+        slab->block_bytes = block_bytes_(class_index);
+
+        return slab;
+    }
+
+    void unmap_slab_(Slab *slab)
+    {
+        mapped_bytes_.fetch_sub(SLAB_BYTES, std::memory_order_relaxed);
+
+#if defined(__unix__) || defined(__APPLE__)
+        munmap(slab, SLAB_BYTES);
+#else
+        ::operator delete(slab, std::align_val_t(SLAB_BYTES));
+#endif
+    }
+
+private:
+//-----------------------------------Variables-------------------------------------
+    static constexpr size_t MAGAZINE_BYTES      = 1ul << 16;
+    static constexpr size_t MIN_MAGAZINE_BLOCKS = 4;
+    static constexpr size_t MAX_MAGAZINE_BLOCKS = 64;
+    static constexpr size_t MAX_EMPTY_SLABS     = 1;                // per class, so that one block cannot make a slab flap
+
+    SizeClass classes_[SLAB_CLASSES_QUANTITY];
+    std::atomic<size_t> mapped_bytes_ = 0;
+
+    Allocator *upstream_ = nullptr;
+};
+
+
+// never destroyed: thread caches and static containers may still give blocks back while
+// the process exits, the mappings go away with it
+inline SlabAlloc *slab_allocator()
+{
+    static SlabAlloc *allocator = new SlabAlloc();
+
+    return allocator;
+}
+
+inline SlabAlloc::ThreadCache::~ThreadCache()
+{
+    SlabAlloc *allocator = slab_allocator();
+    for (size_t class_index = 0; class_index < SLAB_CLASSES_QUANTITY; ++class_index)
+    {
+        allocator->drain_(class_index, magazines[class_index], 0);
+    }
+}
+
+
+#endif
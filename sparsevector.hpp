@@ -0,0 +1,437 @@
+#ifndef SPARSE_VECTOR_HPP
+#define SPARSE_VECTOR_HPP
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "bitvector.hpp"
+#include "vector.hpp"
+
+
+const size_t GALLOP_RATIO           = 32;              // below this nonzero ratio a linear merge beats exponential search
+const size_t SPARSE_DIMENSION_LIMIT = (1ull << 31);    // indices fit uint32_t and stay non-negative as signed AVX2 gather lanes
+
+
+// Vector of dimension size() with explicit entries only: strictly increasing indices and their
+// values in two parallel Vectors. Binary operations intersect or merge the index arrays, with
+// galloping when one side is much shorter and 8x8 AVX2 block compares for float
+template<typename Type>
+class SparseVector
+{
+public:
+    using value_type = Type;
+//---------------------------------------------------------------------------------
+    SparseVector(size_t dimension = 0)
+      : dimension_(dimension)
+    {
+        assert(dimension_ < SPARSE_DIMENSION_LIMIT);
+    }
+
+    // nonzero entries of dense
+    SparseVector(const Vector<Type> &dense)
+      : dimension_(dense.size())
+    {
+        assert(dimension_ < SPARSE_DIMENSION_LIMIT);
+
+        for (size_t index = 0; index < dimension_; ++index)
+        {
+            if (dense[index] != Type())
+            {
+                push_back(index, dense[index]);
+            }
+        }
+    }
+
+    // entries of dense marked in occupancy, explicit zeroes included
+    SparseVector(const Vector<Type> &dense, const Vector<bool> &occupancy)
+      : dimension_(dense.size())
+    {
+        assert(dimension_ < SPARSE_DIMENSION_LIMIT);
+        assert(occupancy.size() == dense.size());
+
+        occupancy.for_each_set_bit([this, &dense](size_t index)
+        {
+            push_back(index, dense[index]);
+        });
+    }
+//--------------------------------Size and capacity--------------------------------
+    size_t size() const
+    {
+        return dimension_;
+    }
+
+    size_t nonzeros() const
+    {
+        return indices_.size();
+    }
+
+    bool empty() const
+    {
+        return indices_.empty();
+    }
+
+    void reserve(size_t nonzeros_capacity)
+    {
+        indices_.reserve(nonzeros_capacity);
+        values_.reserve(nonzeros_capacity);
+    }
+//-------------------------------Element access------------------------------------
+    // binary search, Type() for an absent index
+    Type operator [](size_t index) const
+    {
+        assert(index < dimension_);
+
+        size_t position = lower_bound_(indices_, 0, nonzeros(), static_cast<uint32_t> (index));
+        if ((position < nonzeros()) && (indices_[position] == index))
+        {
+            return values_[position];
+        }
+
+        return Type();
+    }
+
+    const Vector<uint32_t> &indices() const
+    {
+        return indices_;
+    }
+
+    const Vector<Type> &values() const
+    {
+        return values_;
+    }
+//----------------------------------Modifiers--------------------------------------
+    // indices have to arrive in increasing order
+    void push_back(size_t index, const Type &value)
+    {
+        if ((index >= dimension_) || (!indices_.empty() && (indices_.back() >= index)))
+        {
+            std::cerr << "ERROR(SparseVector " << this << "): index " << index << " is out of bounds or out of order" << std::endl;
+
+            return;
+        }
+
+        indices_.push_back(static_cast<uint32_t> (index));
+        values_.push_back(value);
+    }
+
+    void clear()
+    {
+        indices_.clear();
+        values_.clear();
+    }
+
+    void swap(SparseVector &other)
+    {
+        std::swap(dimension_, other.dimension_);
+        indices_.swap(other.indices_);
+        values_.swap(other.values_);
+    }
+//---------------------------------Arithmetic--------------------------------------
+    Type dot(const SparseVector &other) const
+    {
+        assert(dimension_ == other.dimension_);
+
+        size_t size       = nonzeros();
+        size_t other_size = other.nonzeros();
+        if ((size == 0) || (other_size == 0))
+        {
+            return Type();
+        }
+
+        if (size * GALLOP_RATIO < other_size)
+        {
+            return dot_galloping_(*this, other);
+        }
+        if (other_size * GALLOP_RATIO < size)
+        {
+            return dot_galloping_(other, *this);
+        }
+
+        return dot_merge_(*this, other);
+    }
+
+    // gathers the dense entries at the explicit indices
+    Type dot(const Vector<Type> &dense) const
+    {
+        assert(dense.size() == dimension_);
+
+        size_t size = nonzeros();
+        if (size == 0)
+        {
+            return Type();
+        }
+
+        const uint32_t *indices = indices_.data();
+        const Type     *values  = values_.data();
+        const Type     *weights = dense.data();
+
+        Type result = Type();
+        size_t position = 0;
+
+#ifdef __AVX2__
+        if constexpr (std::is_same_v<Type, float>)
+        {
+            __m256 sum = _mm256_setzero_ps();
+            for (; position + 8 <= size; position += 8)
+            {
+                __m256i lanes_indices = _mm256_loadu_si256(reinterpret_cast<const __m256i *> (indices + position));
+                __m256  gathered      = _mm256_i32gather_ps(weights, lanes_indices, 4);
+
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(gathered, _mm256_loadu_ps(values + position)));
+            }
+
+            result = horizontal_sum_avx2_(sum);
+        }
+#endif
+
+        for (; position < size; ++position)
+        {
+            result += values[position] * weights[indices[position]];
+        }
+
+        return result;
+    }
+
+    SparseVector add(const SparseVector &other) const
+    {
+        return merge_(other, Type(1));
+    }
+
+    // *this += alpha * x
+    void axpy(const Type &alpha, const SparseVector &x)
+    {
+        SparseVector result = merge_(x, alpha);
+        swap(result);
+    }
+
+    // dense += alpha * (*this), touching only the explicit entries
+    void axpy_to(const Type &alpha, Vector<Type> &dense) const
+    {
+        assert(dense.size() == dimension_);
+
+        size_t size = nonzeros();
+        if (size == 0)
+        {
+            return;
+        }
+
+        const uint32_t *indices = indices_.data();
+        const Type     *values  = values_.data();
+        Type           *target  = dense.data();
+        for (size_t position = 0; position < size; ++position)
+        {
+            target[indices[position]] += alpha * values[position];
+        }
+    }
+//---------------------------------Conversions-------------------------------------
+    Vector<Type> to_dense() const
+    {
+        Vector<Type> result(dimension_);
+
+        size_t size = nonzeros();
+        for (size_t position = 0; position < size; ++position)
+        {
+            result[indices_[position]] = values_[position];
+        }
+
+        return result;
+    }
+
+    Vector<bool> occupancy() const
+    {
+        if (dimension_ == 0)
+        {
+            return Vector<bool>();
+        }
+
+        Vector<bool> result(dimension_, false);
+
+        size_t size = nonzeros();
+        for (size_t position = 0; position < size; ++position)
+        {
+            result.set(indices_[position]);
+        }
+
+        return result;
+    }
+
+private:
+//--------------------------------Utilitary functions------------------------------
+    // first position in [from, to) whose index is not less than key
+    static size_t lower_bound_(const Vector<uint32_t> &indices, size_t from, size_t to, uint32_t key)
+    {
+        while (from < to)
+        {
+            size_t middle = from + ((to - from) >> 1);
+            if (indices[middle] < key)
+            {
+                from = middle + 1;
+            }
+            else
+            {
+                to = middle;
+            }
+        }
+
+        return from;
+    }
+
+    // every index of small is looked up in large by doubling steps from the previous hit
+    static Type dot_galloping_(const SparseVector &small, const SparseVector &large)
+    {
+        size_t small_size = small.nonzeros();
+        size_t large_size = large.nonzeros();
+
+        Type result = Type();
+        size_t low = 0;
+        for (size_t position = 0; (position < small_size) && (low < large_size); ++position)
+        {
+            uint32_t key = small.indices_[position];
+
+            size_t step = 1;
+            size_t high = low;
+            while ((high < large_size) && (large.indices_[high] < key))
+            {
+                low   = high + 1;
+                high += step;
+                step <<= 1;
+            }
+
+            low = lower_bound_(large.indices_, low, std::min(high + 1, large_size), key);
+            if ((low < large_size) && (large.indices_[low] == key))
+            {
+                result += small.values_[position] * large.values_[low];
+            }
+        }
+
+        return result;
+    }
+
+    static Type dot_merge_(const SparseVector &left, const SparseVector &right)
+    {
+        const uint32_t *left_indices  = left.indices_.data();
+        const uint32_t *right_indices = right.indices_.data();
+        const Type     *left_values   = left.values_.data();
+        const Type     *right_values  = right.values_.data();
+
+        size_t left_size  = left.nonzeros();
+        size_t right_size = right.nonzeros();
+        size_t left_pos   = 0;
+        size_t right_pos  = 0;
+
+        Type result = Type();
+
+#ifdef __AVX2__
+        if constexpr (std::is_same_v<Type, float>)
+        {
+            // all 8x8 index pairs of the current blocks through 8 rotations of the right block,
+            // then the block with the smaller maximum is done
+            const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+
+            __m256 sum = _mm256_setzero_ps();
+            while ((left_pos + 8 <= left_size) && (right_pos + 8 <= right_size))
+            {
+                __m256i left_block   = _mm256_loadu_si256(reinterpret_cast<const __m256i *> (left_indices + left_pos));
+                __m256  left_lanes   = _mm256_loadu_ps(left_values + left_pos);
+                __m256i right_block  = _mm256_loadu_si256(reinterpret_cast<const __m256i *> (right_indices + right_pos));
+                __m256  right_lanes  = _mm256_loadu_ps(right_values + right_pos);
+
+                for (size_t rotation = 0; rotation < 8; ++rotation)
+                {
+                    __m256 equal = _mm256_castsi256_ps(_mm256_cmpeq_epi32(left_block, right_block));
+                    sum = _mm256_add_ps(sum, _mm256_and_ps(equal, _mm256_mul_ps(left_lanes, right_lanes)));
+
+                    right_block = _mm256_permutevar8x32_epi32(right_block, rotate);
+                    right_lanes = _mm256_permutevar8x32_ps(right_lanes, rotate);
+                }
+
+                uint32_t left_max  = left_indices[left_pos + 7];
+                uint32_t right_max = right_indices[right_pos + 7];
+                left_pos  += (left_max  <= right_max) ? 8 : 0;
+                right_pos += (right_max <= left_max)  ? 8 : 0;
+            }
+
+            result = horizontal_sum_avx2_(sum);
+        }
+#endif
+
+        while ((left_pos < left_size) && (right_pos < right_size))
+        {
+            uint32_t left_index  = left_indices[left_pos];
+            uint32_t right_index = right_indices[right_pos];
+            if (left_index == right_index)
+            {
+                result += left_values[left_pos] * right_values[right_pos];
+            }
+
+            left_pos  += (left_index  <= right_index) ? 1 : 0;
+            right_pos += (right_index <= left_index)  ? 1 : 0;
+        }
+
+        return result;
+    }
+
+    // union of the index arrays with *this + alpha * other on it
+    SparseVector merge_(const SparseVector &other, const Type &alpha) const
+    {
+        assert(dimension_ == other.dimension_);
+
+        SparseVector result(dimension_);
+        result.reserve(nonzeros() + other.nonzeros());
+
+        size_t left_size  = nonzeros();
+        size_t right_size = other.nonzeros();
+        size_t left_pos   = 0;
+        size_t right_pos  = 0;
+        while ((left_pos < left_size) || (right_pos < right_size))
+        {
+            if ((right_pos == right_size) || ((left_pos < left_size) && (indices_[left_pos] < other.indices_[right_pos])))
+            {
+                result.push_back(indices_[left_pos], values_[left_pos]);
+                ++left_pos;
+            }
+            else if ((left_pos == left_size) || (other.indices_[right_pos] < indices_[left_pos]))
+            {
+                result.push_back(other.indices_[right_pos], alpha * other.values_[right_pos]);
+                ++right_pos;
+            }
+            else
+            {
+                result.push_back(indices_[left_pos], values_[left_pos] + alpha * other.values_[right_pos]);
+                ++left_pos;
+                ++right_pos;
+            }
+        }
+
+        return result;
+    }
+
+#ifdef __AVX2__
+    static float horizontal_sum_avx2_(__m256 sum)
+    {
+        __m128 halves = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+        halves = _mm_add_ps(halves, _mm_movehl_ps(halves, halves));
+        halves = _mm_add_ss(halves, _mm_movehdup_ps(halves));
+
+        return _mm_cvtss_f32(halves);
+    }
+#endif
+
+private:
+//-----------------------------------Variables-------------------------------------
+    size_t dimension_ = 0;
+
+    Vector<uint32_t> indices_;
+    Vector<Type>     values_;
+};
+
+
+#endif
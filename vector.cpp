@@ -56,7 +56,7 @@ int main()
 
     std::copy(v1.begin(), v1.end(), std::ostream_iterator<int>(std::cout, " "));
     std::cout << std::endl;
-    std::sort(v1.rbegin(), v1.rend());
+    v1.sort(std::greater<bool>());
     std::copy(v1.begin(), v1.end(), std::ostream_iterator<int>(std::cout, " "));
     std::cout << std::endl;
     v1.insert(v1.cbegin() + 3, 100);
@@ -9,18 +9,21 @@
 #include <initializer_list>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <new>
 #include <type_traits>
 #include <typeinfo>
 #include <utility>
 #include "chunkalloc.hpp"
 #include "dynamicalloc.hpp"
+#include "growthpolicy.hpp"
+#include "memoryutilities.hpp"
 #include "myforward.hpp"
 #include "mymove.hpp"
 #include "specialvalues.hpp"
 
 
-template<typename Type>
+template<typename Type, typename GrowthPolicy = DoublingGrowth>
 class Vector;
 
 template<typename Container, typename ItType>
@@ -216,7 +219,7 @@ private:
 };
 
 //-----------------------------------Class Vector----------------------------------
-template<typename Type>
+template<typename Type, typename GrowthPolicy>
 class Vector
 {
 public:
@@ -240,6 +243,12 @@ public:
         data_    (const_cast<char *> (UNINIT_PTR))
     {}
 
+    explicit Vector(Allocator &alloc)
+      : Vector()
+    {
+        alloc_ = &alloc;
+    }
+
     Vector(const std::initializer_list<Type> &init_list)
     {
         uint64_t list_size = init_list.size();
@@ -250,12 +259,16 @@ public:
     }
 
     Vector(uint64_t reserved_size, const Type &value = Type())
-      : Vector()
+      : Vector(reserved_size, value, *default_allocator())
+    {}
+
+    Vector(uint64_t reserved_size, const Type &value, Allocator &alloc)
+      : Vector(alloc)
     {
         if (reserved_size != 0)
         {
             capacity_ = calculate_enough_capacity_(reserved_size);
-            data_ = new char[capacity_ * sizeof(Type)];
+            data_ = allocate_data_(capacity_);
 
             size_ = reserved_size;
             
@@ -263,40 +276,38 @@ public:
         }
     }
 
-    Vector(const Vector<Type> &other)
+    Vector(const Vector &other)
       : capacity_(other.capacity_),
         size_    (other.size_)
     {
-        data_ = new char[capacity_ * sizeof(Type)];
+        data_ = allocate_data_(capacity_);
 
         copy_data_to_uninit_place_(data_, other.data_, other.size_);
     }
 
-    Vector<Type> &operator =(const Vector &other)
+    Vector &operator =(const Vector &other)
     {
         destroy_existing_elems_(0, size_);
-        if (data_ != const_cast<char *> (UNINIT_PTR) && data_is_valid_())
-        {
-            delete [] data_;
-        }
+        free_data_();
 
         capacity_ = other.capacity_;
         size_     = other.size_;
-        data_ = new char[capacity_ * sizeof(Type)];
+        data_ = allocate_data_(capacity_);
         copy_data_to_uninit_place_(data_, other.data_,  other.size_);
 
         return *this;
     }
 
-    Vector(Vector<Type> &&other)
+    Vector(Vector &&other) noexcept
     {
         *this = std::move(other);
     }
 
-    Vector<Type> &operator =(Vector<Type> &&other)
+    Vector &operator =(Vector &&other) noexcept
     {
         std::swap(capacity_, other.capacity_);
         std::swap(size_, other.size_);
+        std::swap(alloc_, other.alloc_);
         std::swap(data_, other.data_);
 
         return *this;
@@ -306,10 +317,7 @@ public:
     {
         destroy_existing_elems_(0, size_);
         
-        if ((data_ != const_cast<char *> (UNINIT_PTR)) && data_is_valid_())
-        {
-            delete [] data_;
-        }
+        free_data_();
 
         destroy_fields_();
     }
@@ -319,7 +327,7 @@ public:
     {   
         if (to == VECTOR_MAX_CAPACITY + 1)
         {
-            to = capacity_;
+            to = size_;
         }
 
         std::cout << "Vector[" << this << "]" << std::endl;
@@ -364,6 +372,11 @@ public:
         return capacity_;
     }
 
+    Allocator *get_allocator() const
+    {
+        return alloc_;
+    }
+
     void reserve(uint64_t reserved_capacity)
     {
         if (reserved_capacity <= capacity_)
@@ -373,10 +386,7 @@ public:
 
         char *new_data = vector_realloc_(reserved_capacity);
 
-        if ((data_ != const_cast<char *> (UNINIT_PTR)) && data_is_valid_())
-        {
-            delete [] data_;
-        }
+        free_data_();
 
         data_     = new_data;
         capacity_ = reserved_capacity;
@@ -389,20 +399,18 @@ public:
             return;
         }
 
-        char *new_data = vector_realloc_(size_);
-
-        if ((data_ != const_cast<char *> (UNINIT_PTR)) && data_is_valid_())
-        {
-            delete [] data_;
-        }
+        set_capacity_(size_);
+    }
 
-        data_     = new_data;
-        capacity_ = size_;
+    // bytes shrink_to_fit() would give back
+    uint64_t spare_bytes() const
+    {
+        return (capacity_ - size_) * sizeof(Type);
     }
 //---------------------------------Accessing elements------------------------------
     const Type &operator [](uint64_t index) const
     {
-        return const_cast<const Type &>(const_cast<Vector<Type> *>(this)->operator[](index));
+        return const_cast<const Type &>(const_cast<Vector *>(this)->operator[](index));
     }
 
     Type &operator [](uint64_t index)
@@ -414,7 +422,7 @@ public:
 
     const Type &at(uint64_t index) const
     {
-       return const_cast<const Type &>(const_cast<Vector<Type> *>(this)->at(index));
+       return const_cast<const Type &>(const_cast<Vector *>(this)->at(index));
     }
 
     Type &at(uint64_t index)
@@ -426,7 +434,7 @@ public:
 
     const Type &front() const
     {
-        return const_cast<const Type &>(const_cast<Vector<Type> *>(this)->front());
+        return const_cast<const Type &>(const_cast<Vector *>(this)->front());
     }
 
     Type &front()
@@ -436,7 +444,7 @@ public:
 
     const Type &back() const
     {
-        return const_cast<const Type &>(const_cast<Vector<Type> *>(this)->back());
+        return const_cast<const Type &>(const_cast<Vector *>(this)->back());
     }
 
     Type &back()
@@ -446,7 +454,7 @@ public:
 
     const Type *data() const
     {
-        return const_cast<const Type *>(const_cast<Vector<Type> *>(this)->data());
+        return const_cast<const Type *>(const_cast<Vector *>(this)->data());
     }
 
     Type *data()
@@ -520,6 +528,8 @@ public:
         destroy_existing_elems_(0, size_);
 
         size_ = 0;
+
+        shrink_if_sparse_();
     }
 
     Iterator<Vector> insert(ConstIterator<Vector> pos, const Type &value)
@@ -532,7 +542,10 @@ public:
             return end();
         }
 
-        reserve(size_ > 0 ? size_ * DEFAULT_RESIZE_MULTIPLIER : 1);
+        if (size_ == capacity_)
+        {
+            reserve(calculate_enough_capacity_(size_ + 1));
+        }
         init_elements_(size_, size_ + 1);
         
         move_data_(begin() + index + 1, cbegin() + index, size_ - index);
@@ -584,6 +597,8 @@ public:
 
         --size_;
 
+        shrink_if_sparse_();
+
         return begin() + index;
     }
 
@@ -619,6 +634,8 @@ public:
 
             size_ = new_size;
 
+            shrink_if_sparse_();
+
             return;
         }
         if (new_size <= capacity_)                                                   // new size is bigger than previous but smaller or equal to capacity
@@ -633,10 +650,7 @@ public:
         uint64_t new_capacity = calculate_enough_capacity_(new_size);                 // new size is bigger than capacity
         char *new_data = vector_realloc_(new_capacity);
 
-        if ((data_ != const_cast<char *> (UNINIT_PTR)) && data_is_valid_())
-        {
-            delete [] data_;
-        }
+        free_data_();
 
         data_     = new_data;
         init_elements_(size_, new_size, value);
@@ -645,50 +659,70 @@ public:
         size_     = new_size;
     }
 
-    void swap(Vector &other)
+    // resize() without writing the new elements, for callers that overwrite them at once;
+    // only types that need no construction may be left as raw bytes
+    void resize_for_overwrite(uint64_t new_size)
+        requires std::is_trivially_default_constructible_v<Type> && std::is_trivially_destructible_v<Type>
+    {
+        if (new_size > VECTOR_MAX_CAPACITY)
+        {
+            std::cerr << "ERROR(Vector " << typeid(*this).name() << "): attempt to resize to more than VECTOR_MAX_CAPACITY (which is "
+                      << VECTOR_MAX_CAPACITY << ")" << std::endl;
+
+            return;
+        }
+
+        if (new_size > capacity_)
+        {
+            reserve(calculate_enough_capacity_(new_size));
+        }
+
+        bool shrinks = new_size < size_;
+        size_ = new_size;
+        if (shrinks)
+        {
+            shrink_if_sparse_();
+        }
+    }
+
+    void swap(Vector &other) noexcept
     {
         std::swap(capacity_, other.capacity_);
         std::swap(size_, other.size_);
+        std::swap(alloc_, other.alloc_);
         std::swap(data_, other.data_);
     }
 
-    bool operator ==(const Vector<Type> &other) const = default;
-    bool operator !=(const Vector<Type> &other) const = default;
-    bool operator  <(const Vector<Type> &other) const = default;
-    bool operator  >(const Vector<Type> &other) const = default;
-    bool operator <=(const Vector<Type> &other) const = default;
-    bool operator >=(const Vector<Type> &other) const = default;
+    bool operator ==(const Vector &other) const = default;
+    bool operator !=(const Vector &other) const = default;
+    bool operator  <(const Vector &other) const = default;
+    bool operator  >(const Vector &other) const = default;
+    bool operator <=(const Vector &other) const = default;
+    bool operator >=(const Vector &other) const = default;
 
-    auto operator <=>(const Vector<Type> &other) const
+    auto operator <=>(const Vector &other) const
     {
         return vector_cmp_(other);
     }
 
 private:
 //-----------------------------------Utilitary functions---------------------------
-    uint64_t calculate_enough_capacity_(uint64_t required_size) 
+    uint64_t calculate_enough_capacity_(uint64_t required_size) const
     {
-        uint64_t capacity = 1;
-
-        for (uint64_t base = 32; base > 0; base >>= 1)
-        {
-            if (required_size >= (capacity << base))
-            {
-                capacity <<= base;
-            }
-        }
+        uint64_t capacity = GrowthPolicy::next_capacity(capacity_, required_size, *alloc_, sizeof(Type));
+        assert(capacity >= required_size);
 
-        capacity <<= 1;
+        return capacity;
+    }
 
-        return capacity > VECTOR_MAX_CAPACITY ? VECTOR_MAX_CAPACITY : capacity;
+    Type *elements_() const
+    {
+        return reinterpret_cast<Type *> (data_);
     }
 
     void init_elements_(uint64_t from, uint64_t to, const Type &value = Type())
-    {                                                   
-        for (uint64_t vector_elem_index = from; vector_elem_index < to; ++vector_elem_index)
-        {
-            new (data_ + vector_elem_index * sizeof(Type)) Type(value); 
-        }                                                                       
+    {
+        uninitialized_fill_row(elements_() + from, to - from, value);
     }
 
     void copy_data_to_uninit_place_(char *dest, const char *src, uint64_t quantity)
@@ -698,11 +732,7 @@ private:
             return;
         }
 
-        for (uint64_t index = 0; index < quantity; ++index)
-        {
-            const Type &elem_to_copy = reinterpret_cast<const Type &> (src[index * sizeof(Type)]);
-            new (dest + index * sizeof(Type)) Type(elem_to_copy);
-        }
+        uninitialized_copy_row(reinterpret_cast<Type *> (dest), reinterpret_cast<const Type *> (src), quantity);
     }
 
     void copy_data_(char *dest, const char *src, uint64_t quantity)
@@ -712,56 +742,66 @@ private:
             return;
         }
 
-        Type *casted_dest      = reinterpret_cast<Type *> (dest);
-        const Type *casted_src = reinterpret_cast<const Type *> (src); 
+        copy_data(reinterpret_cast<Type *> (dest), reinterpret_cast<const Type *> (src), quantity);
+    }
 
-        if (dest == src)
-        {
-            return;
-        }
+    void move_data_(Iterator<Vector> dest, ConstIterator<Vector> src, uint64_t quantity)
+    {
+        move_data(elements_() + (dest - begin()), elements_() + (src - cbegin()), quantity);
+    }
 
-        bool from_left_to_right = false;
-        if (dest > src)
-        {
-            from_left_to_right = true;
-            casted_dest += quantity - 1;
-            casted_src  += quantity - 1;
-        }
-        
-        for (uint64_t counter = 0; counter < quantity; ++counter)
-        {
-            std::ptrdiff_t shift = from_left_to_right ? -counter : counter;
-            *(casted_dest + shift) = *(casted_src + shift);
-        }
+    char *allocate_data_(uint64_t capacity)
+    {
+        return alloc_->allocate(capacity * sizeof(Type));
     }
 
-    void move_data_(Iterator<Vector> dest, ConstIterator<Vector> src, uint64_t quantity)
+    void free_data_()
     {
-        if (dest == src)
+        if ((data_ != const_cast<char *> (UNINIT_PTR)) && data_is_valid_())
         {
-            return;
+            alloc_->deallocate(data_, capacity_ * sizeof(Type));
         }
+    }
 
-        bool from_left_to_right = false;
-        if (dest > src)
-        {
-            from_left_to_right = true;
-            dest += quantity - 1;
-            src  += quantity - 1;
-        }
+    // an empty buffer is not allocated at all
+    void set_capacity_(uint64_t new_capacity)
+    {
+        assert(new_capacity >= size_);
+
+        char *new_data = (new_capacity > 0) ? vector_realloc_(new_capacity) : const_cast<char *> (UNINIT_PTR);
+
+        free_data_();
+
+        data_     = new_data;
+        capacity_ = new_capacity;
+    }
 
-        for (uint64_t counter = 0; counter < quantity; ++counter)
+    // only policies with shrink_capacity() ever give memory back on their own
+    void shrink_if_sparse_()
+    {
+        if constexpr (requires { GrowthPolicy::shrink_capacity(capacity_, size_); })
         {
-            std::ptrdiff_t shift = from_left_to_right ? -counter : counter;
-            *(dest + shift) = my_move(*(src + shift));
+            uint64_t new_capacity = GrowthPolicy::shrink_capacity(capacity_, size_);
+            if (new_capacity < capacity_)
+            {
+                set_capacity_(new_capacity);
+            }
         }
     }
 
+    // the old buffer keeps its elements if a copy throws, the new one is given back
     char *vector_realloc_(uint64_t new_capacity)
     {
-        char *new_data = new char[new_capacity * sizeof(Type)];
-        copy_data_to_uninit_place_(new_data, data_, size_);
-        destroy_existing_elems_(0, size_);
+        char *new_data = allocate_data_(new_capacity);
+        try
+        {
+            relocate_row(reinterpret_cast<Type *> (new_data), elements_(), size_);
+        }
+        catch (...)
+        {
+            alloc_->deallocate(new_data, new_capacity * sizeof(Type));
+            throw;
+        }
 
         return new_data;
     }
@@ -775,10 +815,7 @@ private:
 
     void destroy_existing_elems_(uint64_t from, uint64_t to)
     {
-        for (uint64_t index = from; index < to; ++index)
-        {
-            (reinterpret_cast<Type *> (data_))[index].~Type();
-        }
+        destroy_elem_row(elements_(), from, to);
     }
 
     void destroy_fields_()
@@ -788,7 +825,7 @@ private:
         data_     = const_cast<char *> (DESTR_PTR);
     }
 
-    std::strong_ordering vector_cmp_(const Vector<Type> &other) const
+    std::strong_ordering vector_cmp_(const Vector &other) const
     {
         uint64_t this_size  = size();
         uint64_t other_size = other.size();
@@ -822,12 +859,13 @@ private:
 
 private:
 //----------------------------Variables--------------------------------------------
-    static constexpr uint64_t VECTOR_MAX_CAPACITY       = 1024;
-    static constexpr uint64_t DEFAULT_RESIZE_MULTIPLIER = 2;
+    // the byte size of any buffer still fits into a ptrdiff_t
+    static constexpr uint64_t VECTOR_MAX_CAPACITY = static_cast<uint64_t> (std::numeric_limits<std::ptrdiff_t>::max()) / sizeof(Type);
 
     uint64_t capacity_  = 0;
     uint64_t size_      = 0;
-    
+
+    Allocator *alloc_ = default_allocator();
     char *data_ = const_cast<char *> (UNINIT_PTR);
 };
 
@@ -0,0 +1,306 @@
+#ifndef VECTOR_EXPORT_HPP
+#define VECTOR_EXPORT_HPP
+
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <type_traits>
+#include "bitvector.hpp"
+#include "print.hpp"
+#include "vector.hpp"
+
+
+const size_t EXPORT_BUFFER_SIZE = 1ul << 16;
+
+
+// Text form of a whole Vector, only [0, size()) and newline-terminated:
+//     CSV   - 1,2,3 on one line, strings quoted when they hold a comma, quote or newline
+//     LINES - one element per line
+//     JSON  - [1,2,3], strings escaped, non-finite floating point values as null
+//     BITS  - 0101... on one line, Vector<bool> only
+enum class ExportFormat
+{
+    CSV,
+    LINES,
+    JSON,
+    BITS
+};
+
+
+namespace export_detail
+{
+    const size_t MAX_NUMBER_CHARS = 64;             // any arithmetic value through to_chars, with a separator
+
+    // '0'/'1' for the 8 bits of every byte value, most significant first, alone or each
+    // followed by a separator
+    struct BitTextTable
+    {
+        char bits[256][8];
+        char commas[256][16];
+        char newlines[256][16];
+    };
+
+    inline constexpr BitTextTable make_bit_text_table()
+    {
+        BitTextTable table = {};
+        for (size_t byte = 0; byte < 256; ++byte)
+        {
+            for (size_t bit = 0; bit < 8; ++bit)
+            {
+                char digit = ((byte >> (7 - bit)) & 1) ? '1' : '0';
+
+                table.bits[byte][bit] = digit;
+                table.commas[byte][2 * bit]       = digit;
+                table.commas[byte][2 * bit + 1]   = ',';
+                table.newlines[byte][2 * bit]     = digit;
+                table.newlines[byte][2 * bit + 1] = '\n';
+            }
+        }
+
+        return table;
+    }
+
+    inline constexpr BitTextTable BIT_TEXT_TABLE = make_bit_text_table();
+
+    inline void append_csv_field(PrintBuffer &buffer, std::string_view text)
+    {
+        if (text.find_first_of(",\"\n\r") == std::string_view::npos)
+        {
+            buffer.append(text);
+
+            return;
+        }
+
+        buffer.append('"');
+        for (size_t quote = text.find('"'); quote != std::string_view::npos; quote = text.find('"'))
+        {
+            buffer.append(text.data(), quote + 1);
+            buffer.append('"');
+            text.remove_prefix(quote + 1);
+        }
+        buffer.append(text);
+        buffer.append('"');
+    }
+
+    inline void append_json_string(PrintBuffer &buffer, std::string_view text)
+    {
+        static const char HEX_DIGITS[] = "0123456789abcdef";
+
+        buffer.append('"');
+
+        size_t plain = 0;
+        for (size_t index = 0; index < text.size(); ++index)
+        {
+            unsigned char symbol = static_cast<unsigned char> (text[index]);
+            if ((symbol >= 0x20) && (symbol != '"') && (symbol != '\\'))
+            {
+                continue;
+            }
+
+            buffer.append(text.data() + plain, index - plain);
+            plain = index + 1;
+
+            switch (symbol)
+            {
+                case '"':  buffer.append("\\\"", 2); break;
+                case '\\': buffer.append("\\\\", 2); break;
+                case '\n': buffer.append("\\n", 2);  break;
+                case '\r': buffer.append("\\r", 2);  break;
+                case '\t': buffer.append("\\t", 2);  break;
+                default:
+                {
+                    char escape[6] = {'\\', 'u', '0', '0', HEX_DIGITS[symbol >> 4], HEX_DIGITS[symbol & 0xF]};
+                    buffer.append(escape, sizeof(escape));
+                }
+            }
+        }
+
+        buffer.append(text.data() + plain, text.size() - plain);
+        buffer.append('"');
+    }
+
+    template<typename Type>
+    char *write_number(char *cursor, const Type &value, ExportFormat format)
+    {
+        if constexpr (std::is_floating_point_v<Type>)
+        {
+            if ((format == ExportFormat::JSON) && !std::isfinite(value))
+            {
+                std::memcpy(cursor, "null", 4);
+
+                return cursor + 4;
+            }
+        }
+
+        return std::to_chars(cursor, cursor + MAX_NUMBER_CHARS, value).ptr;
+    }
+
+    template<typename Type>
+    std::string_view text_of(const Type &value)
+    {
+        if constexpr (std::is_same_v<Type, char>)
+        {
+            return std::string_view(&value, 1);
+        }
+        else if constexpr (std::is_pointer_v<Type>)
+        {
+            return (value != nullptr) ? std::string_view(value) : std::string_view();
+        }
+        else
+        {
+            return std::string_view(value);
+        }
+    }
+}
+
+
+template<typename Type>
+void export_vector(PrintBuffer &buffer, const Vector<Type> &vector, ExportFormat format = ExportFormat::LINES)
+{
+    constexpr bool IS_NUMBER = std::is_arithmetic_v<Type> && !std::is_same_v<Type, char>;
+    constexpr bool IS_TEXT   = std::is_same_v<Type, char> || (print_category<Type>() == PrintCategory::STRING);
+    static_assert(IS_NUMBER || IS_TEXT, "export_vector writes arithmetic and string elements");
+
+    if (format == ExportFormat::BITS)
+    {
+        std::cerr << "ERROR(export_vector): BITS is only defined for Vector<bool>" << std::endl;
+
+        return;
+    }
+
+    size_t size = vector.size();
+    bool lines = format == ExportFormat::LINES;
+
+    if (format == ExportFormat::JSON)
+    {
+        buffer.append('[');
+    }
+
+    for (size_t index = 0; index < size; ++index)
+    {
+        if constexpr (IS_NUMBER)
+        {
+            char *cursor = buffer.prepare(export_detail::MAX_NUMBER_CHARS + 1);
+            if (cursor == nullptr)
+            {
+                return;
+            }
+
+            char *end = cursor;
+            if ((index > 0) && !lines)
+            {
+                *end++ = ',';
+            }
+
+            end = export_detail::write_number(end, vector[index], format);
+            if (lines)
+            {
+                *end++ = '\n';
+            }
+
+            buffer.commit(static_cast<size_t> (end - cursor));
+        }
+        else
+        {
+            if ((index > 0) && !lines)
+            {
+                buffer.append(',');
+            }
+
+            std::string_view text = export_detail::text_of(vector[index]);
+            switch (format)
+            {
+                case ExportFormat::CSV:  export_detail::append_csv_field(buffer, text);   break;
+                case ExportFormat::JSON: export_detail::append_json_string(buffer, text); break;
+                default:                 buffer.append(text); buffer.append('\n');        break;
+            }
+        }
+    }
+
+    if (format == ExportFormat::JSON)
+    {
+        buffer.append(']');
+    }
+    if (!lines)
+    {
+        buffer.append('\n');
+    }
+}
+
+// a byte of bits per table lookup, whole words at a time
+inline void export_vector(PrintBuffer &buffer, const Vector<bool> &vector, ExportFormat format = ExportFormat::LINES)
+{
+    using export_detail::BIT_TEXT_TABLE;
+
+    size_t size = vector.size();
+    bool separated = format != ExportFormat::BITS;
+    bool lines     = format == ExportFormat::LINES;
+
+    const char (*table)[16] = lines ? BIT_TEXT_TABLE.newlines : BIT_TEXT_TABLE.commas;
+    size_t chars_per_bit    = separated ? 2 : 1;
+
+    if (format == ExportFormat::JSON)
+    {
+        buffer.append('[');
+    }
+
+    // CSV and JSON have no separator after the last element, it is written on its own
+    size_t body = ((format == ExportFormat::CSV) || (format == ExportFormat::JSON)) && (size > 0) ? size - 1 : size;
+    for (size_t first = 0; first < body; first += BITS_IN_WORD)
+    {
+        uint64_t word = vector.get_word(first >> BITS_TO_WORDS_OFFSET);
+        size_t bits   = std::min(BITS_IN_WORD, body - first);
+
+        char *cursor = buffer.prepare(bits * chars_per_bit);
+        if (cursor == nullptr)
+        {
+            return;
+        }
+
+        for (size_t bit = 0; bit < bits; bit += 8)
+        {
+            uint8_t byte  = static_cast<uint8_t> (word >> (BITS_IN_WORD - 8 - bit));
+            size_t  count = std::min<size_t>(8, bits - bit) * chars_per_bit;
+
+            std::memcpy(cursor, separated ? table[byte] : BIT_TEXT_TABLE.bits[byte], count);
+            cursor += count;
+        }
+
+        buffer.commit(bits * chars_per_bit);
+    }
+
+    if (body < size)
+    {
+        buffer.append(vector.test(size - 1) ? '1' : '0');
+    }
+
+    if (format == ExportFormat::JSON)
+    {
+        buffer.append(']');
+    }
+    if (!lines)
+    {
+        buffer.append('\n');
+    }
+}
+
+// through a thread-local buffer, false if writing to fd failed
+template<typename Type>
+bool export_vector(int fd, const Vector<Type> &vector, ExportFormat format = ExportFormat::LINES)
+{
+    thread_local char storage[EXPORT_BUFFER_SIZE];
+    PrintBuffer buffer(storage, sizeof(storage), fd);
+
+    export_vector(buffer, vector, format);
+    buffer.flush();
+
+    return !buffer.failed();
+}
+
+
+#endif
@@ -0,0 +1,251 @@
+#ifndef VECTOR_LOADER_HPP
+#define VECTOR_LOADER_HPP
+
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "vector.hpp"
+
+
+const size_t MIN_PARSE_CHUNK_BYTES = (1ul << 20);        // smaller pieces of text are not worth a thread
+
+
+namespace loader_detail
+{
+    inline bool is_delimiter(char symbol)
+    {
+        return (symbol == ' ') || (symbol == '\n') || (symbol == ',') || (symbol == '\t') || (symbol == '\r');
+    }
+
+    // first delimiter at or after position, so that no number is cut in two
+    inline const char *next_boundary(const char *position, const char *end)
+    {
+        while ((position < end) && !is_delimiter(*position))
+        {
+            ++position;
+        }
+
+        return position;
+    }
+
+    // runs of non-delimiters in [begin, end), every value takes exactly one
+    inline size_t count_tokens(const char *begin, const char *end)
+    {
+        size_t tokens = 0;
+        bool   inside = false;
+        for (const char *position = begin; position < end; ++position)
+        {
+            bool delimiter = is_delimiter(*position);
+            tokens += (!delimiter && !inside) ? 1 : 0;
+            inside  = !delimiter;
+        }
+
+        return tokens;
+    }
+
+    // values of [begin, end) into segment, nullptr on success or where parsing stopped;
+    // a counting pass sizes the segment exactly before anything is parsed
+    template<typename Type>
+    const char *parse_chunk(const char *begin, const char *end, Vector<Type> &segment)
+    {
+        size_t estimate = count_tokens(begin, end);
+        segment.resize(estimate);
+        if (segment.size() != estimate)
+        {
+            return begin;
+        }
+
+        Type  *values = segment.data();
+        size_t count  = 0;
+
+        const char *position = begin;
+        while (true)
+        {
+            while ((position < end) && is_delimiter(*position))
+            {
+                ++position;
+            }
+            if (position == end)
+            {
+                break;
+            }
+
+            if ((*position == '+') && (position + 1 < end) && (position[1] != '-'))
+            {
+                ++position;                                                 // from_chars takes no plus sign
+            }
+
+            Type value = Type();
+            std::from_chars_result result = std::from_chars(position, end, value);
+            if ((result.ec != std::errc()) || ((result.ptr < end) && !is_delimiter(*result.ptr)))
+            {
+                segment.resize(count);
+
+                return position;
+            }
+
+            assert(count < estimate);
+            values[count++] = value;
+            position = result.ptr;
+        }
+
+        segment.resize(count);
+
+        return nullptr;
+    }
+}
+
+
+// Numbers separated by whitespace or commas in [begin, end) appended to result: the text is
+// cut at delimiters into one chunk per thread, every thread parses its chunk with from_chars
+// into its own segment, and the segments are copied behind each other into result at once.
+// false if some text is not a number of Type or the values do not fit into a Vector
+template<typename Type>
+bool parse_vector(const char *begin, const char *end, Vector<Type> &result, size_t threads_quantity = 0)
+{
+    static_assert(std::is_arithmetic_v<Type> && !std::is_same_v<Type, bool>, "parse_vector reads numbers");
+    assert(begin <= end);
+
+    size_t bytes = static_cast<size_t> (end - begin);
+    if (threads_quantity == 0)
+    {
+        threads_quantity = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads_quantity = std::max<size_t>(1, std::min(threads_quantity, bytes / MIN_PARSE_CHUNK_BYTES));
+
+    const char **bounds   = new const char *[threads_quantity + 1];
+    const char **failures = new const char *[threads_quantity]{};
+    Vector<Type> *segments = new Vector<Type>[threads_quantity];
+
+    bounds[0] = begin;
+    for (size_t chunk = 1; chunk < threads_quantity; ++chunk)
+    {
+        const char *approximate = std::max(bounds[chunk - 1], begin + chunk * (bytes / threads_quantity));
+        bounds[chunk] = loader_detail::next_boundary(approximate, end);
+    }
+    bounds[threads_quantity] = end;
+
+    std::thread *workers = new std::thread[threads_quantity - 1];
+    for (size_t worker = 0; worker < threads_quantity - 1; ++worker)
+    {
+        workers[worker] = std::thread([=]()
+                                      {
+                                          failures[worker] = loader_detail::parse_chunk(bounds[worker], bounds[worker + 1], segments[worker]);
+                                      });
+    }
+    failures[threads_quantity - 1] = loader_detail::parse_chunk(bounds[threads_quantity - 1], end, segments[threads_quantity - 1]);
+
+    for (size_t worker = 0; worker < threads_quantity - 1; ++worker)
+    {
+        workers[worker].join();
+    }
+
+    bool success = true;
+    size_t total = result.size();
+    for (size_t chunk = 0; (chunk < threads_quantity) && success; ++chunk)
+    {
+        if (failures[chunk] != nullptr)
+        {
+            std::cerr << "ERROR(parse_vector): cannot read a value at offset " << (failures[chunk] - begin) << std::endl;
+
+            success = false;
+        }
+
+        total += segments[chunk].size();
+    }
+
+    if (success)
+    {
+        size_t offset = result.size();
+        result.resize(total);
+        if (result.size() != total)
+        {
+            std::cerr << "ERROR(parse_vector): " << total << " values do not fit into a Vector" << std::endl;
+
+            success = false;
+        }
+
+        for (size_t chunk = 0; (chunk < threads_quantity) && success; ++chunk)
+        {
+            size_t quantity = segments[chunk].size();
+            if (quantity > 0)
+            {
+                std::memcpy(result.data() + offset, segments[chunk].data(), quantity * sizeof(Type));
+            }
+
+            offset += quantity;
+        }
+    }
+
+    delete [] workers;
+    delete [] segments;
+    delete [] failures;
+    delete [] bounds;
+
+    return success;
+}
+
+// the file is mapped instead of read, so the parsing threads work on the page cache directly
+template<typename Type>
+bool load_vector(const char *path, Vector<Type> &result, size_t threads_quantity = 0)
+{
+    assert(path != nullptr);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "ERROR(load_vector): cannot open " << path << ": " << std::strerror(errno) << std::endl;
+
+        return false;
+    }
+
+    struct stat status = {};
+    if (fstat(fd, &status) != 0)
+    {
+        std::cerr << "ERROR(load_vector): cannot stat " << path << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+
+        return false;
+    }
+
+    size_t bytes = static_cast<size_t> (status.st_size);
+    if (bytes == 0)
+    {
+        close(fd);
+
+        return true;
+    }
+
+    void *mapping = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "ERROR(load_vector): cannot map " << path << ": " << std::strerror(errno) << std::endl;
+
+        return false;
+    }
+
+    madvise(mapping, bytes, MADV_SEQUENTIAL);
+
+    const char *text = static_cast<const char *> (mapping);
+    bool success = parse_vector(text, text + bytes, result, threads_quantity);
+
+    munmap(mapping, bytes);
+
+    return success;
+}
+
+
+#endif